@@ -14,8 +14,194 @@ CFastLED FastLED;
 
 CLEDController *CLEDController::m_pHead = NULL;
 CLEDController *CLEDController::m_pTail = NULL;
+
+#if FASTLED_APA102_HDR == 1
+// For a 16 bit color value c (8 bit color times 8 bit scale), level L and
+// 8 bit value v = c * 31 / (256 * L) show the same light.  The level is the
+// smallest for which the brightest channel still fits in 8 bits.
+const uint8_t apa102_hdr_level[256] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 6, 6, 6, 6, 6, 6, 6,
+    6, 7, 7, 7, 7, 7, 7, 7, 7, 8, 8, 8, 8, 8, 8, 8,
+    8, 9, 9, 9, 9, 9, 9, 9, 9, 9, 10, 10, 10, 10, 10, 10,
+    10, 10, 11, 11, 11, 11, 11, 11, 11, 11, 12, 12, 12, 12, 12, 12,
+    12, 12, 13, 13, 13, 13, 13, 13, 13, 13, 14, 14, 14, 14, 14, 14,
+    14, 14, 14, 15, 15, 15, 15, 15, 15, 15, 15, 16, 16, 16, 16, 16,
+    16, 16, 16, 17, 17, 17, 17, 17, 17, 17, 17, 18, 18, 18, 18, 18,
+    18, 18, 18, 18, 19, 19, 19, 19, 19, 19, 19, 19, 20, 20, 20, 20,
+    20, 20, 20, 20, 21, 21, 21, 21, 21, 21, 21, 21, 22, 22, 22, 22,
+    22, 22, 22, 22, 23, 23, 23, 23, 23, 23, 23, 23, 23, 24, 24, 24,
+    24, 24, 24, 24, 24, 25, 25, 25, 25, 25, 25, 25, 25, 26, 26, 26,
+    26, 26, 26, 26, 26, 27, 27, 27, 27, 27, 27, 27, 27, 27, 28, 28,
+    28, 28, 28, 28, 28, 28, 29, 29, 29, 29, 29, 29, 29, 29, 30, 30,
+    30, 30, 30, 30, 30, 30, 31, 31, 31, 31, 31, 31, 31, 31, 31, 31,
+};
+
+// round(31 * 2^16 / (256 * L))
+const uint16_t apa102_hdr_reciprocal[32] = {
+    0, 7936, 3968, 2645, 1984, 1587, 1323, 1134, 992, 882, 794, 721, 661, 610, 567, 529,
+    496, 467, 441, 418, 397, 378, 361, 345, 331, 317, 305, 294, 283, 274, 265, 256,
+};
+#endif
+
+CLEDController::~CLEDController() {
+	free(m_pData16Out);
+#if FASTLED_TEMPORAL_DITHER
+	free(m_pDitherError);
+#endif
+}
+
+#if FASTLED_SCALE_LUT
+const uint8_t *CLEDController::getLUT(const CRGB & scale) {
+	bool gammaChanged = (m_pLUTGamma != m_pGamma);
+	for(int i = 0; i < 3; i++) {
+		if(m_bLUTBuilt && !gammaChanged && m_LUTScale.raw[i] == scale.raw[i]) { continue; }
+		uint8_t s = scale.raw[i];
+		for(int x = 0; x < 256; x++) {
+			m_LUT[i][x] = scale8(m_pGamma ? m_pGamma[x] : x, s);
+		}
+		m_LUTScale.raw[i] = s;
+	}
+	m_pLUTGamma = m_pGamma;
+	m_bLUTBuilt = true;
+	return &m_LUT[0][0];
+}
+#endif
+
+#if FASTLED_TEMPORAL_DITHER
+uint8_t *CLEDController::getDitherError(int nLeds) {
+	if(nLeds > m_nDitherErrorLeds) {
+		uint8_t *pErr = (uint8_t*)realloc(m_pDitherError, nLeds * 3);
+		if(pErr == NULL) { return NULL; }
+		// start every byte at a different phase, so that neighbouring pixels of the same color do not
+		// step up and down together
+		for(int i = m_nDitherErrorLeds * 3; i < nLeds * 3; i++) {
+			pErr[i] = i * 167;
+		}
+		m_pDitherError = pErr;
+		m_nDitherErrorLeds = nLeds;
+	}
+	return m_pDitherError;
+}
+#endif
+
+// Cut 16 bit values down to 8 bits.  A value v is v / 257 in 8 bit steps, which is (v - v / 256) / 256 to within
+// 1/256 of a step; the low byte of that is rounded off with a threshold that depends on the dithering: fixed at one
+// half, the pixel's own carried error for TEMPORAL_DITHER, or a threshold that goes through all 256 values over
+// 256 frames, offset per byte, for BINARY_DITHER.
+enum { ROUND16_NEAREST, ROUND16_TEMPORAL, ROUND16_ORDERED };
+
+template<int MODE> static void convert16(const CRGB16 *src, CRGB *dst, int nLeds, const uint16_t mul[3], uint8_t *err, uint8_t q) {
+	for(int i = 0; i < nLeds; i++) {
+		for(int c = 0; c < 3; c++) {
+			uint32_t v = ((uint32_t)src[i].raw[c] * mul[c]) >> 8;
+			uint16_t w = v - (v >> 8);
+			if(MODE == ROUND16_TEMPORAL) {
+				w += *err;
+				*err++ = w & 0xFF;
+			} else if(MODE == ROUND16_ORDERED) {
+				w += q;
+				q += 167;
+			} else {
+				w += 128;
+			}
+			dst[i].raw[c] = w >> 8;
+		}
+	}
+}
+
+void CLEDController::showLeds16(uint8_t brightness) {
+	// the 8 bit pixels go into a buffer of our own, since m_Data belongs to the sketch.  Without one, send black
+	// rather than leave this controller out of the frame.
+	// the old contents don't matter, so the buffer is replaced rather than grown
+	if(m_nLeds > m_nData16OutLeds) {
+		free(m_pData16Out);
+		m_pData16Out = (CRGB*)malloc(m_nLeds * sizeof(CRGB));
+		m_nData16OutLeds = m_pData16Out ? m_nLeds : 0;
+		if(m_pData16Out == NULL) {
+			showColor(CRGB::Black, m_nLeds, CRGB::Black);
+			return;
+		}
+	}
+
+	// the same adjustment as the 8 bit path, with zero staying black
+	CRGB adj = getAdjustment(brightness);
+	uint16_t mul[3];
+	for(int c = 0; c < 3; c++) {
+		mul[c] = adj.raw[c] ? adj.raw[c] + 1 : 0;
+	}
+
+	uint8_t *pErr = NULL;
+#if FASTLED_TEMPORAL_DITHER
+	if(m_DitherMode == TEMPORAL_DITHER) { pErr = getDitherError(m_nLeds); }
+#endif
+	if(pErr) {
+		convert16<ROUND16_TEMPORAL>(m_Data16, m_pData16Out, m_nLeds, mul, pErr, 0);
+	} else if(m_DitherMode != DISABLE_DITHER) {
+		// the frame count with its bits reversed, so that consecutive frames are far apart
+		uint8_t f = m_nFrame16++;
+		f = (f & 0xF0) >> 4 | (f & 0x0F) << 4;
+		f = (f & 0xCC) >> 2 | (f & 0x33) << 2;
+		f = (f & 0xAA) >> 1 | (f & 0x55) << 1;
+		convert16<ROUND16_ORDERED>(m_Data16, m_pData16Out, m_nLeds, mul, NULL, f);
+	} else {
+		convert16<ROUND16_NEAREST>(m_Data16, m_pData16Out, m_nLeds, mul, NULL, 0);
+	}
+
+	// the data is final, so send it as it is
+	EDitherMode d = m_DitherMode;
+	m_DitherMode = DISABLE_DITHER;
+	show(m_pData16Out, m_nLeds, CRGB(255, 255, 255));
+	m_DitherMode = d;
+}
+
 static uint32_t lastshow = 0;
 
+#if defined(ESP32)
+#include "esp_timer.h"
+#include "esp_log.h"
+#include "freertos/semphr.h"
+
+// Waits shorter than this are spun; longer ones sleep on a one-shot timer, which wakes
+// us up this much early, so the core is free for other tasks in the meantime.
+#ifndef FASTLED_PACING_SPIN_MICROS
+#define FASTLED_PACING_SPIN_MICROS 100
+#endif
+
+static esp_timer_handle_t pacingTimer = NULL;
+static SemaphoreHandle_t pacingSem = NULL;
+static bool pacingSpinOnly = false;
+
+static void pacingWakeup(void *) { xSemaphoreGive(pacingSem); }
+
+static void sleepUntil(uint32_t deadline) {
+	int32_t left = (int32_t)(deadline - micros());
+	if(left > 2 * FASTLED_PACING_SPIN_MICROS && !pacingSpinOnly) {
+		if(pacingTimer == NULL) {
+			// if there is no timer to be had, spin from now on rather than trying again every frame
+			pacingSem = xSemaphoreCreateBinary();
+			esp_timer_create_args_t args = {};
+			args.callback = pacingWakeup;
+			args.name = "fastled_pacing";
+			if(pacingSem == NULL || esp_timer_create(&args, &pacingTimer) != ESP_OK) {
+				ESP_LOGW("FastLED", "no pacing timer, waiting for frames by spinning");
+				pacingTimer = NULL;
+				pacingSpinOnly = true;
+			}
+		}
+		if(pacingTimer != NULL && esp_timer_start_once(pacingTimer, left - FASTLED_PACING_SPIN_MICROS) == ESP_OK) {
+			xSemaphoreTake(pacingSem, portMAX_DELAY);
+		}
+	}
+	while((int32_t)(deadline - micros()) > 0);
+}
+#else
+static void sleepUntil(uint32_t deadline) {
+	while((int32_t)(deadline - micros()) > 0);
+}
+#endif
+
 uint32_t _frame_cnt=0;
 uint32_t _retry_cnt=0;
 
@@ -26,6 +212,7 @@ CFastLED::CFastLED() {
 	// m_nControllers = 0;
 	m_Scale = 255;
 	m_nFPS = 0;
+	m_nTargetMicros = 0;
 	m_pPowerFunc = NULL;
 	m_nPowerData = 0xFFFFFFFF;
 }
@@ -42,25 +229,115 @@ CLEDController &CFastLED::addLeds(CLEDController *pLed,
 	return *pLed;
 }
 
+// The steps for sending a batch of controllers, each taken by all of them in turn.  Controllers that hold
+// their data until flush() are shown and flushed first, so their hardware is busy while the others write out
+// their data; then we wait for all of them.  The frame takes as long as the slowest controller, rather than
+// the sum of all of them.  flush() is idempotent per driver, so calling it on every controller is fine.
+enum { FLUSH_BEGIN, FLUSH_SHOW_HELD, FLUSH_SEND_HELD, FLUSH_SHOW_OTHERS, FLUSH_SEND_OTHERS, FLUSH_WAIT, FLUSH_STEPS };
+
+// Telemetry hooks, which compile to nothing unless FASTLED_TELEMETRY is set
+#if FASTLED_TELEMETRY
+#define TELEMETRY(X) X
+#else
+#define TELEMETRY(X)
+#endif
+
+static void flushStep(CLEDController *pCur, int step, uint8_t scale, bool noDither, const struct CRGB *color = NULL) {
+	bool held = pCur->holdsUntilFlush();
+	TELEMETRY(uint32_t start = micros());
+	switch(step) {
+		case FLUSH_BEGIN:
+			pCur->beginFlush();
+			break;
+		case FLUSH_SHOW_HELD:
+		case FLUSH_SHOW_OTHERS:
+			if(held == (step == FLUSH_SHOW_HELD)) {
+				uint8_t d = pCur->getDither();
+				if(noDither && d == BINARY_DITHER) { pCur->setDither(0); }
+				if(color) {
+					pCur->showColor(*color, scale);
+				} else {
+					pCur->showLeds(scale);
+				}
+				pCur->setDither(d);
+				TELEMETRY(CTelemetry::shown(pCur, held, start));
+			}
+			break;
+		case FLUSH_SEND_HELD:
+		case FLUSH_SEND_OTHERS:
+			if(held == (step == FLUSH_SEND_HELD)) {
+				pCur->flush();
+				TELEMETRY(if(held) { CTelemetry::sent(pCur, start); });
+			}
+			break;
+		case FLUSH_WAIT:
+			pCur->waitFlush();
+			TELEMETRY(CTelemetry::flushed(pCur, held));
+			break;
+	}
+}
+
 void CFastLED::show(uint8_t scale) {
+	TELEMETRY(m_Telemetry.beginFrame());
+
+	// guard against showing too rapidly
+	waitForNextFrame();
+	TELEMETRY(m_Telemetry.mark(CTelemetry::IDLE));
+
+	// If we have a function for computing power, use it!
+	if(m_pPowerFunc) {
+		scale = (*m_pPowerFunc)(scale, m_nPowerData);
+	}
+	TELEMETRY(m_Telemetry.mark(CTelemetry::POWER));
+
+	for(int step = 0; step < FLUSH_STEPS; step++) {
+		CLEDController *pCur = CLEDController::head();
+		while(pCur) {
+			flushStep(pCur, step, scale, m_nFPS < 100);
+			pCur = pCur->next();
+		}
+		TELEMETRY(if(step == FLUSH_SHOW_HELD) { m_Telemetry.mark(CTelemetry::ENCODE); });
+	}
+	TELEMETRY(m_Telemetry.endFrame());
+	countFPS();
+}
+
+void CFastLED::flushLeds(CLEDController **pControllers, int nControllers, uint8_t scale) {
+	TELEMETRY(m_Telemetry.beginFrame());
+
 	// guard against showing too rapidly
-	while(m_nMinMicros && ((micros()-lastshow) < m_nMinMicros));
-	lastshow = micros();
+	waitForNextFrame();
+	TELEMETRY(m_Telemetry.mark(CTelemetry::IDLE));
 
 	// If we have a function for computing power, use it!
 	if(m_pPowerFunc) {
 		scale = (*m_pPowerFunc)(scale, m_nPowerData);
 	}
+	TELEMETRY(m_Telemetry.mark(CTelemetry::POWER));
+
+	for(int step = 0; step < FLUSH_STEPS; step++) {
+		for(int i = 0; i < nControllers; i++) {
+			flushStep(pControllers[i], step, scale, m_nFPS < 100);
+		}
+		TELEMETRY(if(step == FLUSH_SHOW_HELD) { m_Telemetry.mark(CTelemetry::ENCODE); });
+	}
+	TELEMETRY(m_Telemetry.endFrame());
+	countFPS();
+}
+
+void CFastLED::flushLeds(uint32_t mask, uint8_t scale) {
+	CLEDController *pControllers[32];
+	int nControllers = 0;
 
 	CLEDController *pCur = CLEDController::head();
-	while(pCur) {
-		uint8_t d = pCur->getDither();
-		if(m_nFPS < 100) { pCur->setDither(0); }
-		pCur->showLeds(scale);
-		pCur->setDither(d);
+	for(int i = 0; pCur && i < 32; i++) {
+		if(mask & (1UL << i)) {
+			pControllers[nControllers++] = pCur;
+		}
 		pCur = pCur->next();
 	}
-	countFPS();
+
+	flushLeds(pControllers, nControllers, scale);
 }
 
 int CFastLED::count() {
@@ -86,22 +363,25 @@ CLEDController & CFastLED::operator[](int x) {
 }
 
 void CFastLED::showColor(const struct CRGB & color, uint8_t scale) {
-	while(m_nMinMicros && ((micros()-lastshow) < m_nMinMicros));
-	lastshow = micros();
+	TELEMETRY(m_Telemetry.beginFrame());
+	waitForNextFrame();
+	TELEMETRY(m_Telemetry.mark(CTelemetry::IDLE));
 
 	// If we have a function for computing power, use it!
 	if(m_pPowerFunc) {
 		scale = (*m_pPowerFunc)(scale, m_nPowerData);
 	}
-
-	CLEDController *pCur = CLEDController::head();
-	while(pCur) {
-		uint8_t d = pCur->getDither();
-		if(m_nFPS < 100) { pCur->setDither(0); }
-		pCur->showColor(color, scale);
-		pCur->setDither(d);
-		pCur = pCur->next();
+	TELEMETRY(m_Telemetry.mark(CTelemetry::POWER));
+
+	for(int step = 0; step < FLUSH_STEPS; step++) {
+		CLEDController *pCur = CLEDController::head();
+		while(pCur) {
+			flushStep(pCur, step, scale, m_nFPS < 100, &color);
+			pCur = pCur->next();
+		}
+		TELEMETRY(if(step == FLUSH_SHOW_HELD) { m_Telemetry.mark(CTelemetry::ENCODE); });
 	}
+	TELEMETRY(m_Telemetry.endFrame());
 	countFPS();
 }
 
@@ -150,6 +430,16 @@ void CFastLED::setCorrection(const struct CRGB & correction) {
 	}
 }
 
+#if FASTLED_SCALE_LUT
+void CFastLED::setGamma(const uint8_t *gammaTable) {
+	CLEDController *pCur = CLEDController::head();
+	while(pCur) {
+		pCur->setGamma(gammaTable);
+		pCur = pCur->next();
+	}
+}
+#endif
+
 void CFastLED::setDither(uint8_t ditherMode)  {
 	CLEDController *pCur = CLEDController::head();
 	while(pCur) {
@@ -219,6 +509,28 @@ void CFastLED::countFPS(int nFrames) {
   }
 }
 
+void CFastLED::setTargetFPS(uint16_t fps) {
+	m_nTargetMicros = fps ? (1000000 / fps) : 0;
+}
+
+void CFastLED::waitForNextFrame() {
+	uint32_t period = (m_nTargetMicros > m_nMinMicros) ? m_nTargetMicros : m_nMinMicros;
+	uint32_t deadline = lastshow + period;
+	int32_t early = (int32_t)(deadline - micros());
+	if(period && early > 0) {
+		sleepUntil(deadline);
+	}
+
+	// with a target rate, frames are due at fixed times: a frame that starts a little late keeps its
+	// slot, so that the rate does not drift, as long as it stays at least m_nMinMicros after the last one.
+	// Anything later than that starts the schedule over from now.
+	if(m_nTargetMicros && early > -(int32_t)(period - m_nMinMicros)) {
+		lastshow = deadline;
+	} else {
+		lastshow = micros();
+	}
+}
+
 void CFastLED::setMaxRefreshRate(uint16_t refresh, bool constrain) {
   if(constrain) {
     // if we're constraining, the new value of m_nMinMicros _must_ be higher than previously (because we're only
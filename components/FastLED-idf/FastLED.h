@@ -10,7 +10,10 @@
 
 // prefer I2S? Comment this in.
 // Not the default because haven't tried it as much, does work
+// Defining FASTLED_ESP32_RMT in the build selects the RMT driver instead.
+#ifndef FASTLED_ESP32_RMT
 #define FASTLED_ESP32_I2S
+#endif
 
 #include "esp32-hal.h"
 
@@ -117,6 +120,7 @@ template<uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2852 : public WS2812Control
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class WS2812B : public WS2812Controller800Khz<DATA_PIN, RGB_ORDER> {};
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class GS1903 : public WS2812Controller800Khz<DATA_PIN, RGB_ORDER> {};
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class SK6812 : public SK6812Controller<DATA_PIN, RGB_ORDER> {};
+template<uint8_t DATA_PIN, EOrder RGB_ORDER> class SK6812RGBW : public SK6812RGBWController<DATA_PIN, RGB_ORDER> {};
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class SK6822 : public SK6822Controller<DATA_PIN, RGB_ORDER> {};
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class APA106 : public SK6822Controller<DATA_PIN, RGB_ORDER> {};
 template<uint8_t DATA_PIN, EOrder RGB_ORDER> class PL9823 : public PL9823Controller<DATA_PIN, RGB_ORDER> {};
@@ -192,8 +196,15 @@ class CFastLED {
 	uint8_t  m_Scale; 				///< The current global brightness scale setting
 	uint16_t m_nFPS;					///< Tracking for current FPS value
 	uint32_t m_nMinMicros;		///< minimum µs between frames, used for capping frame rates.
+	uint32_t m_nTargetMicros;	///< µs between frames for setTargetFPS, or 0
 	uint32_t m_nPowerData;		///< max power use parameter
 	power_func m_pPowerFunc;	///< function for overriding brightness when using FastLED.show();
+#if FASTLED_TELEMETRY
+	CTelemetry m_Telemetry;		///< where the time of each frame went
+#endif
+
+	/// Wait until the next frame may be sent, as set by setMaxRefreshRate and setTargetFPS
+	void waitForNextFrame();
 
 public:
 	CFastLED();
@@ -511,6 +522,25 @@ public:
 	/// Update all our controllers with the current led colors
 	void show() { show(m_Scale); }
 
+	/// Update only the given controllers with their current led colors, using the passed in brightness.
+	/// The controllers are sent together, in parallel where the hardware allows it, so strips that change
+	/// quickly can be refreshed without re-sending the strips that did not change.
+	/// @param pControllers - the controllers to update
+	/// @param nControllers - how many entries are in pControllers
+	/// @param scale - the brightness to show them at
+	void flushLeds(CLEDController **pControllers, int nControllers, uint8_t scale);
+
+	/// Update only the given controllers with their current led colors
+	void flushLeds(CLEDController **pControllers, int nControllers) { flushLeds(pControllers, nControllers, m_Scale); }
+
+	/// Update only the selected controllers with their current led colors, using the passed in brightness.
+	/// @param mask - bit N selects the Nth controller, in the order they were added with addLeds
+	/// @param scale - the brightness to show them at
+	void flushLeds(uint32_t mask, uint8_t scale);
+
+	/// Update only the selected controllers with their current led colors
+	void flushLeds(uint32_t mask) { flushLeds(mask, m_Scale); }
+
 	/// clear the leds, wiping the local array of data, optionally black out the leds as well
 	/// @param writeData whether or not to write out to the leds as well
 	void clear(bool writeData = false);
@@ -543,9 +573,16 @@ public:
 	/// @param correction A CRGB structure describin the color correction.
 	void setCorrection(const struct CRGB & correction);
 
+#if FASTLED_SCALE_LUT
+	/// Set a gamma curve for all added led strips, applied to each byte before the color adjustment.
+	/// @param gammaTable 256 entries, which are not copied, or NULL to turn gamma off
+	void setGamma(const uint8_t *gammaTable);
+#endif
+
 	/// Set the dithering mode.  Sets the dithering mode for all added led strips, overriding
 	/// whatever previous dithering option those controllers may have had.
-	/// @param ditherMode - what type of dithering to use, either BINARY_DITHER or DISABLE_DITHER
+	/// @param ditherMode - what type of dithering to use, either BINARY_DITHER or DISABLE_DITHER, or TEMPORAL_DITHER
+	/// with FASTLED_TEMPORAL_DITHER.  BINARY_DITHER is skipped while the frame rate is below 100, TEMPORAL_DITHER is not.
 	void setDither(uint8_t ditherMode = BINARY_DITHER);
 
 	/// Set the maximum refresh rate.  This is global for all leds.  Attempts to
@@ -557,6 +594,12 @@ public:
 	/// @param constrain - constrain refresh rate to the slowest speed yet set
 	void setMaxRefreshRate(uint16_t refresh, bool constrain=false);
 
+	/// Set a frame rate for show() to keep.  show() sleeps until the next frame is due, rather than
+	/// spinning, and frames are scheduled at fixed intervals, so a frame that runs a little late does
+	/// not push back the ones after it.  The rate never goes above the one set by setMaxRefreshRate.
+	/// @param fps - frames per second, or 0 to send frames as fast as they are shown
+	void setTargetFPS(uint16_t fps);
+
 	/// for debugging, will keep track of time between calls to countFPS, and every
 	/// nFrames calls, it will update an internal counter for the current FPS.
 	/// @todo make this a rolling counter
@@ -567,6 +610,13 @@ public:
 	/// @returns the most recently computed FPS value
 	uint16_t getFPS() { return m_nFPS; }
 
+#if FASTLED_TELEMETRY
+	/// Get the render, power, encode, wire and idle times of recent frames, with their statistics over all
+	/// frames and per controller.  From other tasks, read them through CTelemetry::copy().
+	/// @returns the telemetry kept by show(), showColor() and flushLeds()
+	CTelemetry & getTelemetry() { return m_Telemetry; }
+#endif
+
 	/// Get how many controllers have been registered
   /// @returns the number of controllers (strips) that have been added with addLeds
 	int count();
@@ -237,7 +237,10 @@ protected:
 		mSPI.select();
 
 		uint8_t s0 = pixels.getScale0(), s1 = pixels.getScale1(), s2 = pixels.getScale2();
-#if FASTLED_USE_GLOBAL_BRIGHTNESS == 1
+#if FASTLED_APA102_HDR == 1
+		// brightness is chosen per pixel, by loadAndScaleAPA102HDR
+		(void)s0; (void)s1; (void)s2;
+#elif FASTLED_USE_GLOBAL_BRIGHTNESS == 1
 		const uint16_t maxBrightness = 0x1F;
 		uint16_t brightness = ((((uint16_t)max(max(s0, s1), s2) + 1) * maxBrightness - 1) >> 8) + 1;
 		s0 = (maxBrightness * s0 + (brightness >> 1)) / brightness;
@@ -249,7 +252,13 @@ protected:
 
 		startBoundary();
 		while (pixels.has(1)) {
+#if FASTLED_APA102_HDR == 1
+			uint8_t b0, b1, b2;
+			uint8_t brightness = pixels.loadAndScaleAPA102HDR(b0, b1, b2);
+			writeLed(brightness, b0, b1, b2);
+#else
 			writeLed(brightness, pixels.loadAndScale0(0, s0), pixels.loadAndScale1(0, s1), pixels.loadAndScale2(0, s2));
+#endif
 			pixels.stepDithering();
 			pixels.advanceData();
 		}
@@ -302,7 +311,10 @@ protected:
 		mSPI.select();
 
 		uint8_t s0 = pixels.getScale0(), s1 = pixels.getScale1(), s2 = pixels.getScale2();
-#if FASTLED_USE_GLOBAL_BRIGHTNESS == 1
+#if FASTLED_APA102_HDR == 1
+		// brightness is chosen per pixel, by loadAndScaleAPA102HDR
+		(void)s0; (void)s1; (void)s2;
+#elif FASTLED_USE_GLOBAL_BRIGHTNESS == 1
 		const uint16_t maxBrightness = 0x1F;
 		uint16_t brightness = ((((uint16_t)max(max(s0, s1), s2) + 1) * maxBrightness - 1) >> 8) + 1;
 		s0 = (maxBrightness * s0 + (brightness >> 1)) / brightness;
@@ -314,7 +326,13 @@ protected:
 
 		startBoundary();
 		while (pixels.has(1)) {
+#if FASTLED_APA102_HDR == 1
+			uint8_t b0, b1, b2;
+			uint8_t brightness = pixels.loadAndScaleAPA102HDR(b0, b1, b2);
+			writeLed(brightness, b0, b1, b2);
+#else
 			writeLed(brightness, pixels.loadAndScale0(0, s0), pixels.loadAndScale1(0, s1), pixels.loadAndScale2(0, s2));
+#endif
 			pixels.stepDithering();
 			pixels.advanceData();
 		}
@@ -450,6 +468,11 @@ protected:
 /// Provides timing definitions for the variety of clockless controllers supplied by the library.
 /// @{
 
+// How RGBW chipsets derive the white byte (see EWhiteMode)
+#if !defined(FASTLED_RGBW_WHITE_MODE)
+    #define FASTLED_RGBW_WHITE_MODE RGBW_EXACT
+#endif
+
 // Allow clock that clockless controller is based on to have different
 // frequency than the CPU.
 #if !defined(CLOCKLESS_FREQUENCY)
@@ -495,6 +518,9 @@ class SM16703Controller : public ClocklessController<DATA_PIN, 3 * FMUL, 4 * FMU
 template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
 class SK6812Controller : public ClocklessController<DATA_PIN, 3 * FMUL, 3 * FMUL, 4 * FMUL, RGB_ORDER> {};
 
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB, EWhiteMode WHITE = FASTLED_RGBW_WHITE_MODE>
+class SK6812RGBWController : public ClocklessController<DATA_PIN, 3 * FMUL, 3 * FMUL, 4 * FMUL, RGB_ORDER, 0, false, 5, WHITE> {};
+
 template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
 class UCS1903Controller400Khz : public ClocklessController<DATA_PIN, 4 * FMUL, 12 * FMUL, 4 * FMUL, RGB_ORDER> {};
 
@@ -608,6 +634,9 @@ class SK6822Controller : public ClocklessController<DATA_PIN, C_NS(375), C_NS(10
 template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
 class SK6812Controller : public ClocklessController<DATA_PIN, C_NS(300), C_NS(300), C_NS(600), RGB_ORDER> {};
 
+template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB, EWhiteMode WHITE = FASTLED_RGBW_WHITE_MODE>
+class SK6812RGBWController : public ClocklessController<DATA_PIN, C_NS(300), C_NS(300), C_NS(600), RGB_ORDER, 0, false, 5, WHITE> {};
+
 template <uint8_t DATA_PIN, EOrder RGB_ORDER = RGB>
 class SM16703Controller : public ClocklessController<DATA_PIN, C_NS(300), C_NS(600), C_NS(300), RGB_ORDER> {};
 
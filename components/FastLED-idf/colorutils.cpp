@@ -3,6 +3,7 @@
 
 #include <stdint.h>
 #include <math.h>
+#include <string.h>
 
 #include "FastLED.h"
 
@@ -169,6 +170,77 @@ void fill_gradient_RGB( CRGB* leds, uint16_t numLeds, const CRGB& c1, const CRGB
 
 
 
+// Batch kernels for nscale8 and nblend, SIMD within a register: a 32 bit
+// word holds four channel bytes, split into its even and its odd bytes,
+// each in a 16 bit lane, so one multiply scales two bytes.  A lane's
+// product is at most 0xFFFF, so it never carries into the next one, and
+// the results are bit for bit those of scale8 and blend8.  Bytes before
+// the first aligned word and after the last one go one at a time.  Only
+// for the C versions of scale8 and blend8; AVR keeps its assembly.
+#define SWAR_NSCALE8 (SCALE8_C == 1)
+#define SWAR_NBLEND ((SCALE8_C == 1) && (BLEND8_C == 1) && (FASTLED_BLEND_FIXED == 1))
+
+typedef uint32_t __attribute__((may_alias)) swar_word_t;
+
+#if SWAR_NSCALE8
+static void nscale8_bytes( uint8_t* p, uint32_t n, uint8_t scale)
+{
+#if (FASTLED_SCALE8_FIXED == 1)
+    const uint32_t m = (uint32_t)scale + 1;
+#else
+    const uint32_t m = scale;
+#endif
+
+    for( ; n && ((uintptr_t)p & 3); n--, p++) {
+        *p = (*p * m) >> 8;
+    }
+
+    swar_word_t* w = (swar_word_t*)p;
+    for( ; n >= 4; n -= 4, w++) {
+        uint32_t x = *w;
+        uint32_t even = (((x & 0x00FF00FF) * m) >> 8) & 0x00FF00FF;
+        uint32_t odd  = (((x >> 8) & 0x00FF00FF) * m) & 0xFF00FF00;
+        *w = even | odd;
+    }
+
+    for( p = (uint8_t*)w; n; n--, p++) {
+        *p = (*p * m) >> 8;
+    }
+}
+#endif
+
+#if SWAR_NBLEND
+// The overlay can be at any alignment, so its words are read with memcpy
+static void nblend_bytes( uint8_t* p, const uint8_t* q, uint32_t n, fract8 amountOfOverlay)
+{
+#if (FASTLED_SCALE8_FIXED == 1)
+    const uint32_t ma = 256 - amountOfOverlay;
+    const uint32_t mb = (uint32_t)amountOfOverlay + 1;
+#else
+    const uint32_t ma = 255 - amountOfOverlay;
+    const uint32_t mb = amountOfOverlay;
+#endif
+
+    for( ; n && ((uintptr_t)p & 3); n--, p++, q++) {
+        *p = (*p * ma + *q * mb) >> 8;
+    }
+
+    swar_word_t* w = (swar_word_t*)p;
+    for( ; n >= 4; n -= 4, w++, q += 4) {
+        uint32_t x = *w;
+        uint32_t y;
+        memcpy( &y, q, 4);
+        uint32_t even = (((x & 0x00FF00FF) * ma + (y & 0x00FF00FF) * mb) >> 8) & 0x00FF00FF;
+        uint32_t odd  = (((x >> 8) & 0x00FF00FF) * ma + ((y >> 8) & 0x00FF00FF) * mb) & 0xFF00FF00;
+        *w = even | odd;
+    }
+
+    for( p = (uint8_t*)w; n; n--, p++, q++) {
+        *p = (*p * ma + *q * mb) >> 8;
+    }
+}
+#endif
+
 void nscale8_video( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
     for( uint16_t i = 0; i < num_leds; i++) {
@@ -204,9 +276,13 @@ void nscale8_raw( CRGB* leds, uint16_t num_leds, uint8_t scale)
 
 void nscale8( CRGB* leds, uint16_t num_leds, uint8_t scale)
 {
+#if SWAR_NSCALE8
+    nscale8_bytes( (uint8_t*)leds, num_leds * 3UL, scale);
+#else
     for( uint16_t i = 0; i < num_leds; i++) {
         leds[i].nscale8( scale);
     }
+#endif
 }
 
 void fadeUsingColor( CRGB* leds, uint16_t numLeds, const CRGB& colormask)
@@ -261,6 +337,24 @@ CRGB& nblend( CRGB& existing, const CRGB& overlay, fract8 amountOfOverlay )
 
 void nblend( CRGB* existing, CRGB* overlay, uint16_t count, fract8 amountOfOverlay)
 {
+#if SWAR_NBLEND
+    // Overlapping arrays come out as if blended one pixel at a time,
+    // except with the overlay one pixel behind: nblend_bytes reads it a
+    // word ahead of its writes, so that case takes the loop below
+    if( overlay + 1 != existing) {
+        if( amountOfOverlay == 0) {
+            return;
+        }
+        if( amountOfOverlay == 255) {
+            for( uint16_t i = 0; i < count; i++) {
+                existing[i] = overlay[i];
+            }
+            return;
+        }
+        nblend_bytes( (uint8_t*)existing, (const uint8_t*)overlay, count * 3UL, amountOfOverlay);
+        return;
+    }
+#endif
     for( uint16_t i = count; i; i--) {
         nblend( *existing, *overlay, amountOfOverlay);
         existing++;
@@ -863,6 +957,103 @@ CRGB ColorFromPalette( const CRGBPalette256& pal, uint8_t index, uint8_t brightn
 }
 
 
+// 16 bit color
+
+void fill_solid( struct CRGB16 * leds, int numToFill,
+                 const struct CRGB16& color)
+{
+    for( int i = 0; i < numToFill; i++) {
+        leds[i] = color;
+    }
+}
+
+void fill_gradient_RGB( CRGB16* leds,
+                        uint16_t startpos, const CRGB16& startcolor,
+                        uint16_t endpos,   const CRGB16& endcolor )
+{
+    if( endpos < startpos ) {
+        fill_gradient_RGB( leds, endpos, endcolor, startpos, startcolor);
+        return;
+    }
+
+    // step by a 16 bit fraction of the way, so that every pixel gets
+    // the exact interpolation instead of an accumulated one
+    uint16_t pixeldistance = endpos - startpos;
+    uint32_t step = pixeldistance ? (0xFFFFUL << 16) / pixeldistance : 0;
+    uint32_t frac32 = 0;
+    for( uint16_t i = startpos; i <= endpos; i++) {
+        leds[i] = startcolor.lerp16( endcolor, frac32 >> 16);
+        frac32 += step;
+    }
+    leds[endpos] = endcolor;
+}
+
+void nscale16( CRGB16* leds, uint16_t num_leds, fract16 scale)
+{
+    for( uint16_t i = 0; i < num_leds; i++) {
+        leds[i].nscale16( scale);
+    }
+}
+
+void fadeToBlackBy( CRGB16* leds, uint16_t num_leds, fract16 fadeBy)
+{
+    nscale16( leds, num_leds, 0xFFFF - fadeBy);
+}
+
+CRGB16 blend( const CRGB16& p1, const CRGB16& p2, fract16 amountOfP2 )
+{
+    return p1.lerp16( p2, amountOfP2);
+}
+
+CRGB16& nblend( CRGB16& existing, const CRGB16& overlay, fract16 amountOfOverlay )
+{
+    existing = existing.lerp16( overlay, amountOfOverlay);
+    return existing;
+}
+
+void nblend( CRGB16* existing, const CRGB16* overlay, uint16_t count, fract16 amountOfOverlay)
+{
+    for( uint16_t i = count; i; i--) {
+        nblend( *existing, *overlay, amountOfOverlay);
+        existing++;
+        overlay++;
+    }
+}
+
+// The top 'bits' bits of the index pick one of the 2^bits entries, the
+// rest are the fraction of the way to the next one
+static CRGB16 ColorFromEntries16( const CRGB* entries, uint8_t bits, uint16_t index, fract16 brightness, TBlendType blendType)
+{
+    uint16_t hi = index >> (16 - bits);
+    fract16 frac = (uint16_t)(index << bits);
+
+    CRGB16 color( entries[hi]);
+    if( frac && blendType != NOBLEND) {
+        uint16_t next = (hi + 1) & ((1 << bits) - 1);
+        color = color.lerp16( CRGB16( entries[next]), frac);
+    }
+    if( brightness != 0xFFFF) {
+        color.nscale16( brightness);
+    }
+    return color;
+}
+
+CRGB16 ColorFromPalette16( const CRGBPalette16& pal, uint16_t index, fract16 brightness, TBlendType blendType)
+{
+    return ColorFromEntries16( pal.entries, 4, index, brightness, blendType);
+}
+
+CRGB16 ColorFromPalette16( const CRGBPalette32& pal, uint16_t index, fract16 brightness, TBlendType blendType)
+{
+    return ColorFromEntries16( pal.entries, 5, index, brightness, blendType);
+}
+
+CRGB16 ColorFromPalette16( const CRGBPalette256& pal, uint16_t index, fract16 brightness, TBlendType blendType)
+{
+    return ColorFromEntries16( pal.entries, 8, index, brightness, blendType);
+}
+
+
 CHSV ColorFromPalette( const struct CHSVPalette16& pal, uint8_t index, uint8_t brightness, TBlendType blendType)
 {
     //      hi4 = index >> 4;
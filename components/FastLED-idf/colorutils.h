@@ -1612,6 +1612,46 @@ CHSV ColorFromPalette( const CHSVPalette32& pal,
                       TBlendType blendType=LINEARBLEND);
 
 
+// 16 bit color
+//
+// The same operations for CRGB16 pixels, with 16 bit fractions, for
+// effects whose 8 bit steps show.  Send CRGB16 arrays with
+// CLEDController::setLeds16().
+void fill_solid( struct CRGB16 * leds, int numToFill,
+                 const struct CRGB16& color);
+
+void fill_gradient_RGB( CRGB16* leds,
+                        uint16_t startpos, const CRGB16& startcolor,
+                        uint16_t endpos,   const CRGB16& endcolor );
+
+void nscale16(      CRGB16* leds, uint16_t num_leds, fract16 scale);
+void fadeToBlackBy( CRGB16* leds, uint16_t num_leds, fract16 fadeBy);
+
+CRGB16  blend( const CRGB16& p1, const CRGB16& p2, fract16 amountOfP2 );
+CRGB16& nblend( CRGB16& existing, const CRGB16& overlay, fract16 amountOfOverlay );
+void    nblend( CRGB16* existing, const CRGB16* overlay, uint16_t count, fract16 amountOfOverlay);
+
+// ColorFromPalette16 - the palette entries are 8 bit, but the 16 bit
+//                      index, the blend between entries and the
+//                      brightness are not: the top bits of the index
+//                      pick an entry, and the rest are the fraction of
+//                      the way to the next one.
+CRGB16 ColorFromPalette16( const CRGBPalette16& pal,
+                           uint16_t index,
+                           fract16 brightness=0xFFFF,
+                           TBlendType blendType=LINEARBLEND);
+
+CRGB16 ColorFromPalette16( const CRGBPalette32& pal,
+                           uint16_t index,
+                           fract16 brightness=0xFFFF,
+                           TBlendType blendType=LINEARBLEND);
+
+CRGB16 ColorFromPalette16( const CRGBPalette256& pal,
+                           uint16_t index,
+                           fract16 brightness=0xFFFF,
+                           TBlendType blendType=LINEARBLEND);
+
+
 // Fill a range of LEDs with a sequece of entryies from a palette
 template <typename PALETTE>
 void fill_palette(CRGB* L, uint16_t N, uint8_t startIndex, uint8_t incIndex,
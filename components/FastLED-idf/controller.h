@@ -8,6 +8,7 @@
 #include "led_sysdefs.h"
 #include "pixeltypes.h"
 #include "color.h"
+#include "telemetry.h"
 #include <stddef.h>
 
 FASTLED_NAMESPACE_BEGIN
@@ -23,6 +24,7 @@ FASTLED_NAMESPACE_BEGIN
 
 #define DISABLE_DITHER 0x00
 #define BINARY_DITHER 0x01
+#define TEMPORAL_DITHER 0x02
 typedef uint8_t EDitherMode;
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -40,6 +42,10 @@ class CLEDController {
 protected:
     friend class CFastLED;
     CRGB *m_Data;
+    CRGB16 *m_Data16;
+    CRGB *m_pData16Out;
+    int m_nData16OutLeds;
+    uint8_t m_nFrame16;
     CLEDController *m_pNext;
     CRGB m_ColorCorrection;
     CRGB m_ColorTemperature;
@@ -47,6 +53,21 @@ protected:
     int m_nLeds;
     static CLEDController *m_pHead;
     static CLEDController *m_pTail;
+#if FASTLED_TELEMETRY
+    friend class CTelemetry;
+    CControllerTimes m_Times;
+#endif
+#if FASTLED_SCALE_LUT
+    uint8_t m_LUT[3][256];
+    CRGB m_LUTScale;
+    const uint8_t *m_pGamma;
+    const uint8_t *m_pLUTGamma;
+    bool m_bLUTBuilt;
+#endif
+#if FASTLED_TEMPORAL_DITHER
+    uint8_t *m_pDitherError;
+    int m_nDitherErrorLeds;
+#endif
 
     /// set all the leds on the controller to a given color
     ///@param data the crgb color to set the leds to
@@ -62,13 +83,24 @@ protected:
 
 public:
 	/// create an led controller object, add it to the chain of controllers
-    CLEDController() : m_Data(NULL), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_nLeds(0) {
+    CLEDController() : m_Data(NULL), m_Data16(NULL), m_pData16Out(NULL), m_nData16OutLeds(0), m_nFrame16(0), m_ColorCorrection(UncorrectedColor), m_ColorTemperature(UncorrectedTemperature), m_DitherMode(BINARY_DITHER), m_nLeds(0) {
         m_pNext = NULL;
+#if FASTLED_SCALE_LUT
+        m_pGamma = m_pLUTGamma = NULL;
+        m_bLUTBuilt = false;
+#endif
+#if FASTLED_TEMPORAL_DITHER
+        m_pDitherError = NULL;
+        m_nDitherErrorLeds = 0;
+#endif
         if(m_pHead==NULL) { m_pHead = this; }
         if(m_pTail != NULL) { m_pTail->m_pNext = this; }
         m_pTail = this;
     }
 
+    /// free the buffers the controller allocated for itself
+    virtual ~CLEDController();
+
 	///initialize the LED controller
 	virtual void init() = 0;
 
@@ -87,6 +119,10 @@ public:
 
     /// show function using the "attached to this controller" led data
     void showLeds(uint8_t brightness=255) {
+        if(m_Data16) {
+            showLeds16(brightness);
+            return;
+        }
         show(m_Data, m_nLeds, getAdjustment(brightness));
     }
 
@@ -95,6 +131,26 @@ public:
         showColor(data, m_nLeds, getAdjustment(brightness));
     }
 
+    /// Start a batch of output.  Controllers that send in parallel with their siblings (the ESP32 RMT
+    /// and I2S drivers) hold on to the data given to showLeds() until flush() is called, instead of
+    /// waiting for every sibling to be shown.  Controllers that write immediately ignore this.
+    virtual void beginFlush() {}
+
+    /// True for controllers that hold on to their data between beginFlush() and flush().  show() sends these
+    /// first, so their hardware is busy while the other controllers write out their data.
+    virtual bool holdsUntilFlush() const { return false; }
+
+    /// Send everything that was shown since beginFlush(), in parallel where the hardware allows it.  May return
+    /// while the data is still going out; waitFlush() waits for it.
+    virtual void flush() {}
+
+    /// Wait until the data sent by flush() is out.
+    virtual void waitFlush() {}
+
+    /// showLeds() for CRGB16 data: scale, adjust and dither m_Data16 into a CRGB buffer of the controller's own,
+    /// then send that unscaled
+    void showLeds16(uint8_t brightness);
+
     /// get the first led controller in the chain of controllers
     static CLEDController *head() { return m_pHead; }
     /// get the next controller in the chain after this one.  will return NULL at the end of the chain
@@ -107,11 +163,22 @@ public:
         return *this;
     }
 
+    /// render in 16 bits: showLeds() converts this array into a CRGB buffer that the controller allocates, with the
+    /// brightness, color adjustment and dithering done in 16 bits, and sends that.  The CRGB array is left alone.
+    /// The array needs as many leds as the controller.  NULL goes back to sending the CRGB array as it is.
+    CLEDController & setLeds16(CRGB16 *data) { m_Data16 = data; return *this; }
+
+    /// Pointer to the CRGB16 array for this controller, or NULL
+    CRGB16* leds16() { return m_Data16; }
+
 	/// zero out the led data managed by this controller
     void clearLedData() {
         if(m_Data) {
             memset8((void*)m_Data, 0, sizeof(struct CRGB) * m_nLeds);
         }
+        if(m_Data16) {
+            memset8((void*)m_Data16, 0, sizeof(struct CRGB16) * m_nLeds);
+        }
     }
 
     /// How many leds does this controller manage?
@@ -142,6 +209,22 @@ public:
     /// get the color temperature, aka whipe point, for this controller
     CRGB getTemperature() { return m_ColorTemperature; }
 
+#if FASTLED_SCALE_LUT
+    /// set a gamma curve, applied to each byte before the color adjustment.  The table is not copied, so it has to
+    /// stay around; fill it with e.g. applyGamma_video(i, 2.2).  NULL turns gamma off.
+    CLEDController & setGamma(const uint8_t *gammaTable) { m_pGamma = gammaTable; return *this; }
+
+    /// get the lookup tables for a combined adjustment, one per RGB channel at channel * 256.  Channels are rebuilt
+    /// when their adjustment or the gamma curve changed since the last call.
+    const uint8_t *getLUT(const CRGB & scale);
+#endif
+
+#if FASTLED_TEMPORAL_DITHER
+    /// get the per pixel rounding error carried between frames by TEMPORAL_DITHER, 3 bytes per led, allocated on
+    /// first use.  Returns NULL if it could not be allocated, which turns the dithering off.
+    uint8_t *getDitherError(int nLeds);
+#endif
+
 	/// Get the combined brightness/color adjustment for this controller
     CRGB getAdjustment(uint8_t scale) {
         return computeAdjustment(scale, m_ColorCorrection, m_ColorTemperature);
@@ -171,6 +254,11 @@ public:
     virtual uint16_t getMaxRefreshRate() const { return 0; }
 };
 
+/// Tables for PixelController::loadAndScaleAPA102HDR.  The current level that fits a 16 bit value, indexed by its high
+/// byte, and for each level the multiplier that turns a 16 bit value into an 8 bit one (times 2^16).
+extern const uint8_t apa102_hdr_level[256];
+extern const uint16_t apa102_hdr_reciprocal[32];
+
 // Pixel controller class.  This is the class that we use to centralize pixel access in a block of data, including
 // support for things like RGB reordering, scaling, dithering, skipping (for ARGB data), and eventually, we will
 // centralize 8/12/16 conversions here as well.
@@ -183,6 +271,12 @@ struct PixelController {
         CRGB mScale;
         int8_t mAdvance;
         int mOffsets[LANES];
+#if FASTLED_SCALE_LUT
+        const uint8_t *mLUT;    // mScale as lookup tables, from CLEDController::getLUT, set by the controller
+#endif
+#if FASTLED_TEMPORAL_DITHER
+        uint8_t *mErr;          // TEMPORAL_DITHER error, 3 bytes per pixel in output order, or NULL; set by the controller
+#endif
 
         PixelController(const PixelController & other) {
             d[0] = other.d[0];
@@ -196,7 +290,12 @@ struct PixelController {
             mAdvance = other.mAdvance;
             mLenRemaining = mLen = other.mLen;
             for(int i = 0; i < LANES; i++) { mOffsets[i] = other.mOffsets[i]; }
-
+#if FASTLED_SCALE_LUT
+            mLUT = other.mLUT;
+#endif
+#if FASTLED_TEMPORAL_DITHER
+            mErr = other.mErr;
+#endif
         }
 
         void initOffsets(int len) {
@@ -212,18 +311,27 @@ struct PixelController {
             mData += skip;
             mAdvance = (advance) ? 3+skip : 0;
             initOffsets(len);
+#if FASTLED_SCALE_LUT
+            mLUT = NULL;
+#endif
         }
 
         PixelController(const CRGB *d, int len, CRGB & s, EDitherMode dither = BINARY_DITHER) : mData((const uint8_t*)d), mLen(len), mLenRemaining(len), mScale(s) {
             enable_dithering(dither);
             mAdvance = 3;
             initOffsets(len);
+#if FASTLED_SCALE_LUT
+            mLUT = NULL;
+#endif
         }
 
         PixelController(const CRGB &d, int len, CRGB & s, EDitherMode dither = BINARY_DITHER) : mData((const uint8_t*)&d), mLen(len), mLenRemaining(len), mScale(s) {
             enable_dithering(dither);
             mAdvance = 0;
             initOffsets(len);
+#if FASTLED_SCALE_LUT
+            mLUT = NULL;
+#endif
         }
 
         void init_binary_dithering() {
@@ -312,8 +420,12 @@ struct PixelController {
 
         // toggle dithering enable
         void enable_dithering(EDitherMode dither) {
+#if FASTLED_TEMPORAL_DITHER
+            mErr = NULL;
+#endif
             switch(dither) {
                 case BINARY_DITHER: init_binary_dithering(); break;
+                // TEMPORAL_DITHER works from mErr, which the controller sets
                 default: d[0]=d[1]=d[2]=e[0]=e[1]=e[2]=0; break;
             }
         }
@@ -346,12 +458,33 @@ struct PixelController {
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t dither(PixelController & pc, uint8_t b) { return b ? qadd8(b, pc.d[RO(SLOT)]) : 0; }
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t dither(PixelController & , uint8_t b, uint8_t d) { return b ? qadd8(b,d) : 0; }
 
+#if FASTLED_SCALE_LUT
+        template<int SLOT>  __attribute__((always_inline)) inline static uint8_t scale(PixelController & pc, uint8_t b) { return pc.mLUT[RO(SLOT) * 256 + b]; }
+#else
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t scale(PixelController & pc, uint8_t b) { return scale8(b, pc.mScale.raw[RO(SLOT)]); }
+#endif
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t scale(PixelController & , uint8_t b, uint8_t scale) { return scale8(b, scale); }
 
+        // Scale to 16 bits (b * s * 256 / 255, to within 1/256), add the rounding error that this pixel carried over
+        // from the last frame, and keep the new one.  The sum is at most 65534, so it fits.  Zero stays zero.
+        __attribute__((always_inline)) inline static uint8_t scaleTemporal(uint8_t b, uint8_t s, uint8_t *err) {
+            if(!b) { return 0; }
+            uint16_t c = b * s;
+            c += (c >> 8) + *err;
+            *err = c & 0xFF;
+            return c >> 8;
+        }
+
+#if FASTLED_TEMPORAL_DITHER
+        __attribute__((always_inline)) inline uint8_t *pixelErr() { return mErr + (mLen - mLenRemaining) * 3; }
+#define FASTLED_TEMPORAL_SCALE(pc, SLOT, b) if(LANES == 1 && pc.mErr) { return scaleTemporal((b), pc.mScale.raw[RO(SLOT)], pc.pixelErr() + RO(SLOT)); }
+#else
+#define FASTLED_TEMPORAL_SCALE(pc, SLOT, b)
+#endif
+
         // composite shortcut functions for loading, dithering, and scaling
-        template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc) { return scale<SLOT>(pc, pc.dither<SLOT>(pc, pc.loadByte<SLOT>(pc))); }
-        template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc, int lane) { return scale<SLOT>(pc, pc.dither<SLOT>(pc, pc.loadByte<SLOT>(pc, lane))); }
+        template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc) { FASTLED_TEMPORAL_SCALE(pc, SLOT, pc.loadByte<SLOT>(pc)); return scale<SLOT>(pc, pc.dither<SLOT>(pc, pc.loadByte<SLOT>(pc))); }
+        template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc, int lane) { FASTLED_TEMPORAL_SCALE(pc, SLOT, pc.loadByte<SLOT>(pc, lane)); return scale<SLOT>(pc, pc.dither<SLOT>(pc, pc.loadByte<SLOT>(pc, lane))); }
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc, int lane, uint8_t d, uint8_t scale) { return scale8(pc.dither<SLOT>(pc, pc.loadByte<SLOT>(pc, lane), d), scale); }
         template<int SLOT>  __attribute__((always_inline)) inline static uint8_t loadAndScale(PixelController & pc, int lane, uint8_t scale) { return scale8(pc.loadByte<SLOT>(pc, lane), scale); }
 
@@ -381,6 +514,48 @@ struct PixelController {
         __attribute__((always_inline)) inline uint8_t advanceAndLoadAndScale0() { return advanceAndLoadAndScale<0>(*this); }
         __attribute__((always_inline)) inline uint8_t stepAdvanceAndLoadAndScale0() { stepDithering(); return advanceAndLoadAndScale<0>(*this); }
 
+        // load, dither and scale a whole pixel for an RGBW chipset, returning the white byte
+        template<EWhiteMode WHITE>  __attribute__((always_inline)) inline uint8_t loadAndScaleRGBW(uint8_t & b0, uint8_t & b1, uint8_t & b2) {
+            b0 = loadAndScale0();
+            b1 = loadAndScale1();
+            b2 = loadAndScale2();
+            if(WHITE == RGBW_OFF) { return 0; }
+
+            uint8_t w = b0 < b1 ? b0 : b1;
+            if(b2 < w) { w = b2; }
+            if(WHITE == RGBW_EXACT) { b0 -= w; b1 -= w; b2 -= w; }
+            return w;
+        }
+
+        // Split the scaled pixel into a 5 bit current level and three 8 bit PWM values, for APA102 style chips.  The
+        // scaled color is kept at 16 bits and the lowest level that fits the brightest channel is picked, so dim
+        // pixels keep their resolution instead of being rounded to a few 8 bit steps.  Returns the level.
+        __attribute__((always_inline)) inline uint8_t loadAndScaleAPA102HDR(uint8_t & b0, uint8_t & b1, uint8_t & b2) {
+#if (FASTLED_SCALE8_FIXED == 1)
+            uint16_t c0 = loadByte<0>(*this) * (getScale0() + 1);
+            uint16_t c1 = loadByte<1>(*this) * (getScale1() + 1);
+            uint16_t c2 = loadByte<2>(*this) * (getScale2() + 1);
+#else
+            uint16_t c0 = loadByte<0>(*this) * getScale0();
+            uint16_t c1 = loadByte<1>(*this) * getScale1();
+            uint16_t c2 = loadByte<2>(*this) * getScale2();
+#endif
+            uint16_t m = c0 > c1 ? c0 : c1;
+            if(c2 > m) { m = c2; }
+
+            uint8_t level = apa102_hdr_level[m >> 8];
+            uint32_t r = apa102_hdr_reciprocal[level];
+            b0 = hdrValue(c0, r);
+            b1 = hdrValue(c1, r);
+            b2 = hdrValue(c2, r);
+            return level;
+        }
+
+        __attribute__((always_inline)) inline static uint8_t hdrValue(uint16_t c, uint32_t r) {
+            uint32_t v = (c * r + 0x8000) >> 16;
+            return v > 255 ? 255 : v;
+        }
+
         __attribute__((always_inline)) inline uint8_t getScale0() { return getscale<0>(*this); }
         __attribute__((always_inline)) inline uint8_t getScale1() { return getscale<1>(*this); }
         __attribute__((always_inline)) inline uint8_t getScale2() { return getscale<2>(*this); }
@@ -396,6 +571,12 @@ protected:
   ///@param scale the rgb scaling value for outputting color
   virtual void showColor(const struct CRGB & data, int nLeds, CRGB scale) {
     PixelController<RGB_ORDER, LANES, MASK> pixels(data, nLeds, scale, getDither());
+#if FASTLED_SCALE_LUT
+    pixels.mLUT = getLUT(scale);
+#endif
+#if FASTLED_TEMPORAL_DITHER
+    if(getDither() == TEMPORAL_DITHER) { pixels.mErr = getDitherError(nLeds); }
+#endif
     showPixels(pixels);
   }
 
@@ -405,6 +586,12 @@ protected:
 ///@param scale the rgb scaling to apply to each led before writing it out
   virtual void show(const struct CRGB *data, int nLeds, CRGB scale) {
     PixelController<RGB_ORDER, LANES, MASK> pixels(data, nLeds, scale, getDither());
+#if FASTLED_SCALE_LUT
+    pixels.mLUT = getLUT(scale);
+#endif
+#if FASTLED_TEMPORAL_DITHER
+    if(getDither() == TEMPORAL_DITHER) { pixels.mErr = getDitherError(nLeds); }
+#endif
     showPixels(pixels);
   }
 
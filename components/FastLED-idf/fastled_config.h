@@ -34,7 +34,9 @@
 // fix is enabled by default.  However, if for some reason you have code that is not
 // working right as a result of this (e.g. code that was expecting the old scale8 behavior)
 // you can disable it here.
+#ifndef FASTLED_SCALE8_FIXED
 #define FASTLED_SCALE8_FIXED 1
+#endif
 // #define FASTLED_SCALE8_FIXED 0
 
 // Use this toggle whether to use 'fixed' FastLED pixel blending, including ColorFromPalette.
@@ -43,7 +45,9 @@
 // retrieved from color palettes using LINEAR_BLEND.  This is now fixed, and the
 // fix is enabled by default.  However, if for some reason you wish to run with the old
 // blending, including the integer rounding and color errors, you can disable the bugfix here.
+#ifndef FASTLED_BLEND_FIXED
 #define FASTLED_BLEND_FIXED 1
+#endif
 // #define FASTLED_BLEND_FIXED 0
 
 // Use this toggle whether to use 'fixed' FastLED 8- and 16-bit noise functions.
@@ -66,4 +70,39 @@
 // This enable much more accurate color control on low brightness settings.
 //#define FASTLED_USE_GLOBAL_BRIGHTNESS 1
 
+// Use this toggle to pick the 5 bit current level of each APA102 and SK9822 pixel separately, together with its
+// 8 bit color values.  Dim colors get up to 31 times finer steps.  Overrides FASTLED_USE_GLOBAL_BRIGHTNESS.  Can't be
+// combined with FASTLED_SCALE_LUT.
+//#define FASTLED_APA102_HDR 1
+
+// Use this toggle to have each controller fold its color correction, temperature and brightness (and an optional gamma
+// curve, see setGamma()) into a 256 entry table per channel, rebuilt only when one of them changes.  Encoders then look
+// each byte up instead of scaling it.  Costs 768 bytes of RAM per controller.
+#ifndef FASTLED_SCALE_LUT
+#define FASTLED_SCALE_LUT 0
+#endif
+
+// Use this toggle to add the TEMPORAL_DITHER mode (see setDither()).  Each pixel carries the fraction that was
+// rounded off its 16 bit value (8 bit color times 8 bit scale) over to the next frame, so over a few frames it
+// averages out to the exact value, which removes the banding of dim colors.  Unlike BINARY_DITHER it stays on at
+// low frame rates.  Costs 3 bytes of RAM per pixel for controllers that use it.
+#ifndef FASTLED_TEMPORAL_DITHER
+#define FASTLED_TEMPORAL_DITHER 0
+#endif
+
+// FASTLED_TEMPORAL_DITHER and FASTLED_APA102_HDR work from the 16 bit product of color and scale, which the 8 bit
+// entries of the FASTLED_SCALE_LUT tables don't have, so they would silently skip the tables and the gamma curve.
+#if FASTLED_SCALE_LUT && FASTLED_TEMPORAL_DITHER
+#error "FASTLED_SCALE_LUT and FASTLED_TEMPORAL_DITHER can't be used together"
+#endif
+#if FASTLED_SCALE_LUT && defined(FASTLED_APA102_HDR) && FASTLED_APA102_HDR == 1
+#error "FASTLED_SCALE_LUT and FASTLED_APA102_HDR can't be used together"
+#endif
+
+// Use this toggle to record where the time of every frame goes: rendering, power limiting, encoding, sending and
+// waiting for the next frame, overall and per controller.  See FastLED.getTelemetry() and telemetry.h.
+#ifndef FASTLED_TELEMETRY
+#define FASTLED_TELEMETRY 0
+#endif
+
 #endif
@@ -36,6 +36,8 @@ FASTLED_NAMESPACE_BEGIN
 
      qadd8( i, j) == MIN( (i + j), 0xFF )
      qsub8( i, j) == MAX( (i - j), 0 )
+     qadd16( i, j) == MIN( (i + j), 0xFFFF )
+     qsub16( i, j) == MAX( (i - j), 0 )
 
  - Saturating signed 8-bit ("7-bit") add.
      qadd7( i, j) == MIN( (i + j), 0x7F)
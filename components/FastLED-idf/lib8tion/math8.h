@@ -113,6 +113,24 @@ LIB8STATIC_ALWAYS_INLINE uint8_t qsub8( uint8_t i, uint8_t j)
 #endif
 }
 
+/// add one uint16_t to another, saturating at 0xFFFF
+/// @returns the sum of i & j, capped at 0xFFFF
+LIB8STATIC_ALWAYS_INLINE uint16_t qadd16( uint16_t i, uint16_t j)
+{
+    uint32_t t = (uint32_t)i + j;
+    if( t > 0xFFFF) t = 0xFFFF;
+    return t;
+}
+
+/// subtract one uint16_t from another, saturating at 0x0000
+/// @returns i - j with a floor of 0
+LIB8STATIC_ALWAYS_INLINE uint16_t qsub16( uint16_t i, uint16_t j)
+{
+    int32_t t = (int32_t)i - j;
+    if( t < 0) t = 0;
+    return t;
+}
+
 /// add one byte to another, with one byte result
 LIB8STATIC_ALWAYS_INLINE uint8_t add8( uint8_t i, uint8_t j)
 {
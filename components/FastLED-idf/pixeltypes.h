@@ -865,6 +865,119 @@ inline CRGB operator%( const CRGB& p1, uint8_t d)
 
 
 
+/// Representation of an RGB pixel with 16 bits per channel, for effects whose 8 bit steps show, such as slow fades at
+/// low brightness.  0xFFFF is full brightness, the same as 0xFF in a CRGB.  All operations are integer only.  To send
+/// CRGB16 data, give it to a controller with CLEDController::setLeds16(), which does the brightness scaling and
+/// dithering in 16 bits before the value is cut down to 8.
+struct CRGB16 {
+	union {
+		struct {
+            uint16_t r;
+            uint16_t g;
+            uint16_t b;
+        };
+		uint16_t raw[3];
+	};
+
+    /// Array access operator to index into the crgb16 object
+	inline uint16_t& operator[] (uint8_t x) __attribute__((always_inline))
+    {
+        return raw[x];
+    }
+
+    /// Array access operator to index into the crgb16 object
+    inline const uint16_t& operator[] (uint8_t x) const __attribute__((always_inline))
+    {
+        return raw[x];
+    }
+
+    // default values are UNINITIALIZED
+	inline CRGB16() __attribute__((always_inline))
+    {
+    }
+
+    /// allow construction from R, G, B
+    inline CRGB16( uint16_t ir, uint16_t ig, uint16_t ib)  __attribute__((always_inline))
+        : r(ir), g(ig), b(ib)
+    {
+    }
+
+    /// allow construction from an 8 bit color, with 0xFF becoming 0xFFFF
+    inline CRGB16( const CRGB& rhs) __attribute__((always_inline))
+        : r(rhs.r * 257), g(rhs.g * 257), b(rhs.b * 257)
+    {
+    }
+
+    /// allow assignment from R, G, and B
+	inline CRGB16& setRGB (uint16_t nr, uint16_t ng, uint16_t nb) __attribute__((always_inline))
+    {
+        r = nr;
+        g = ng;
+        b = nb;
+        return *this;
+    }
+
+    /// the nearest 8 bit color
+    inline CRGB toCRGB() const
+    {
+        return CRGB( (r - (r >> 8) + 128) >> 8,
+                     (g - (g >> 8) + 128) >> 8,
+                     (b - (b >> 8) + 128) >> 8);
+    }
+
+    /// add one RGB16 to another, saturating at 0xFFFF for each channel
+    inline CRGB16& operator+= (const CRGB16& rhs )
+    {
+        r = qadd16( r, rhs.r);
+        g = qadd16( g, rhs.g);
+        b = qadd16( b, rhs.b);
+        return *this;
+    }
+
+    /// subtract one RGB16 from another, saturating at 0x0000 for each channel
+    inline CRGB16& operator-= (const CRGB16& rhs )
+    {
+        r = qsub16( r, rhs.r);
+        g = qsub16( g, rhs.g);
+        b = qsub16( b, rhs.b);
+        return *this;
+    }
+
+    /// scale down by a 16 bit fraction, e.g. 0x8000 is 50%
+    inline CRGB16& nscale16 (fract16 scaledown )
+    {
+        r = scale16( r, scaledown);
+        g = scale16( g, scaledown);
+        b = scale16( b, scaledown);
+        return *this;
+    }
+
+    /// fadeToBlackBy is a synonym for nscale16( ..., 0xFFFF-fadefactor)
+    inline CRGB16& fadeToBlackBy (fract16 fadefactor )
+    {
+        return nscale16( 0xFFFF - fadefactor);
+    }
+
+    /// return a new CRGB16 object after performing a linear interpolation between this object and the passed in object
+    inline CRGB16 lerp16( const CRGB16& other, fract16 frac) const
+    {
+        return CRGB16( lerp16by16( r, other.r, frac),
+                       lerp16by16( g, other.g, frac),
+                       lerp16by16( b, other.b, frac));
+    }
+};
+
+inline __attribute__((always_inline)) bool operator== (const CRGB16& lhs, const CRGB16& rhs)
+{
+    return (lhs.r == rhs.r) && (lhs.g == rhs.g) && (lhs.b == rhs.b);
+}
+
+inline __attribute__((always_inline)) bool operator!= (const CRGB16& lhs, const CRGB16& rhs)
+{
+    return !(lhs == rhs);
+}
+
+
 /// RGB orderings, used when instantiating controllers to determine what
 /// order the controller should send RGB data out in, RGB being the default
 /// ordering.
@@ -877,6 +990,15 @@ enum EOrder {
 	BGR=0210
 };
 
+/// How clockless controllers for RGBW chipsets derive the white byte
+/// from an RGB pixel.  RGBW_NONE means the chipset has no white channel.
+enum EWhiteMode {
+	RGBW_NONE=0,	///< three bytes per pixel, no white channel
+	RGBW_EXACT,	///< move the part common to r, g and b into white
+	RGBW_BOOST,	///< white is the part common to r, g and b, which are sent unchanged
+	RGBW_OFF	///< four bytes per pixel, with white always off
+};
+
 FASTLED_NAMESPACE_END
 ///@}
 
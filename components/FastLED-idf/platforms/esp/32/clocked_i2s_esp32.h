@@ -0,0 +1,402 @@
+/*
+ * I2S Driver for clocked chipsets
+ *
+ * Drives up to 23 APA102 or SK9822 strips in parallel, using the same
+ * I2S parallel output as the clockless driver (see
+ * clockless_i2s_esp32.h). One I2S lane carries a clock shared by all
+ * strips, and each of the other lanes carries the data for one strip.
+ * Every data bit takes two I2S words: the first with the clock low,
+ * the second with the clock high, so the LEDs read the bit on the
+ * rising edge.
+ *
+ * It is available whenever the I2S clockless driver is, whose setup
+ * and transpose code it shares. The clockless driver uses I2S_DEVICE,
+ * so this one uses the other device, unless FASTLED_I2S_CLOCKED_DEVICE
+ * says otherwise. Both can be used at the same time.
+ *
+ * Add the strips by declaring the controllers yourself:
+ *
+ *   static I2SClockedController<DATA_PIN, CLOCK_PIN, BGR> strip1;
+ *   FastLED.addLeds(&strip1, leds1, NUM_LEDS);
+ *
+ * All the strips must use the same clock pin and the same clock rate.
+ * As with the clockless driver, the frame is sent once every
+ * controller has been shown. The frame is sent through two DMA
+ * buffers of FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER bytes per strip,
+ * which the interrupt handler refills while the other one is sent.
+ * Strips of different lengths are padded with zeros, which the LEDs
+ * ignore. FastLED.show() starts the frame and waits for it only after
+ * the other controllers have been shown.
+ *
+ * The clock rate is given as a divider of the CPU clock, as with the
+ * SPI controllers (DATA_RATE_MHZ). I2S runs at up to 20MHz, which is a
+ * 10MHz LED clock.
+ */
+
+#pragma once
+
+FASTLED_NAMESPACE_BEGIN
+
+// -- Which I2S device to use
+#ifndef FASTLED_I2S_CLOCKED_DEVICE
+#define FASTLED_I2S_CLOCKED_DEVICE (1 - I2S_DEVICE)
+#endif
+
+// -- Bytes per strip encoded into each DMA buffer
+//    Each byte takes 64 bytes of DMA memory.
+#ifndef FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER
+#define FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER 64
+#endif
+
+// -- The clock is the last lane; the strips get the others
+#define I2S_CLOCKED_MAX_STRIPS 23
+#define I2S_CLOCKED_CLOCK_BIT  (1u << (8 + I2S_CLOCKED_MAX_STRIPS))
+
+// -- Two words per bit, plus a trailing word that leaves the clock low
+#define I2S_CLOCKED_BUFFER_WORDS (FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER * 16 + 1)
+
+// -- Global state, shared by all clocked controllers
+static int gNumClocked = 0;
+static int gNumClockedShown = 0;
+static bool gClockedFlushPending = false;
+static i2s_dev_t * gClockedI2S = NULL;
+static int gClockedBasePin = 0;
+static int gClockedPin = -1;
+static int gClockedDivN = 0;
+static DMABuffer * gClockedBuffers[2];
+static intr_handle_t gClockedIntr = NULL;
+
+// -- Progress of the frame being sent: the next byte to encode, the
+//    next buffer to fill, and the buffers filled with data and sent.
+//    The semaphore is given by the interrupt handler when it is done.
+static xSemaphoreHandle gClockedSem = NULL;
+static bool gClockedSending = false;
+static int gClockedBytes = 0;
+static int gClockedPos = 0;
+static int gClockedCur = 0;
+static int gClockedDataBuffers = 0;
+static int gClockedBuffersSent = 0;
+
+// -- The encoded frame for each lane: start frame, one four byte word
+//    per LED, end frame. Kept here rather than in the controllers,
+//    which are of different template types.
+static uint8_t * gClockedData[I2S_CLOCKED_MAX_STRIPS];
+static int gClockedDataBytes[I2S_CLOCKED_MAX_STRIPS];
+static int gClockedLen[I2S_CLOCKED_MAX_STRIPS];
+
+// -- One byte from each strip, and its bits after the transpose
+static uint8_t gClockedRow[24] __attribute__ ((aligned (4)));
+static uint32_t gClockedBits[8];
+
+template <int DATA_PIN, int CLOCK_PIN, EOrder RGB_ORDER = RGB, uint32_t SPI_SPEED = (F_CPU / 10000000L), bool SK9822 = false>
+class I2SClockedController : public CPixelLEDController<RGB_ORDER>
+{
+    // -- The I2S data clock is twice the LED clock, up to I2S_MAX_CLK
+    enum {
+        LED_CLOCK   = F_CPU / SPI_SPEED,
+        I2S_CLOCK   = (2 * LED_CLOCK > I2S_MAX_CLK) ? I2S_MAX_CLK : 2 * LED_CLOCK,
+        CLOCK_DIV_N = (I2S_BASE_CLK + I2S_CLOCK - 1) / I2S_CLOCK
+    };
+
+    // -- This instantiation forces a check on the pin choice
+    FastPin<DATA_PIN> mFastPin;
+
+    // -- Our lane, or -1 if there were too many strips
+    int            mLane;
+
+ public:
+
+    I2SClockedController() : mLane(-1) {}
+
+    void init()
+    {
+        if (gNumClocked >= I2S_CLOCKED_MAX_STRIPS) {
+            ESP_LOGE("FastLED", "I2S: at most %d clocked strips", I2S_CLOCKED_MAX_STRIPS);
+            return;
+        }
+
+        i2sClockedInit();
+
+        mLane = gNumClocked++;
+
+        // -- Route our lane to the data pin. The lanes are in the same
+        //    order as the controllers, which is the order of the bytes
+        //    in gClockedRow.
+        outputPin(DATA_PIN, mLane);
+
+        if (gClockedPin < 0) {
+            gClockedPin = CLOCK_PIN;
+            outputPin(CLOCK_PIN, I2S_CLOCKED_MAX_STRIPS);
+        } else if (gClockedPin != CLOCK_PIN) {
+            ESP_LOGE("FastLED", "I2S: clocked strips must share clock pin %d", gClockedPin);
+        }
+    }
+
+    virtual void beginFlush() { gClockedFlushPending = true; }
+
+    // -- Start the frame; waitFlush() waits for it
+    virtual void flush()
+    {
+        gClockedFlushPending = false;
+        if (gNumClockedShown > 0) {
+            startFrame();
+        }
+    }
+
+    virtual bool holdsUntilFlush() const { return true; }
+
+    virtual void waitFlush() { waitFrame(); }
+
+protected:
+
+    // -- Encode the strip, then send all of them once every
+    //    controller has been shown
+    virtual void showPixels(PixelController<RGB_ORDER> & pixels)
+    {
+        if (mLane < 0) return;
+
+        // -- The previous frame is sent straight from the encoded strips
+        if (gNumClockedShown == 0) {
+            waitFrame();
+        }
+
+        encode(pixels);
+        gNumClockedShown++;
+
+        if ( ! gClockedFlushPending && gNumClockedShown == gNumClocked) {
+            startFrame();
+            waitFrame();
+        }
+    }
+
+    void encode(PixelController<RGB_ORDER> & pixels)
+    {
+        int nLeds = pixels.size();
+        int endWords = nLeds / 32 + 1;
+        int bytes = 4 + 4 * nLeds + 4 * endWords;
+        if (bytes > gClockedDataBytes[mLane]) {
+            free(gClockedData[mLane]);
+            gClockedData[mLane] = (uint8_t *) malloc(bytes);
+            gClockedDataBytes[mLane] = gClockedData[mLane] ? bytes : 0;
+            if (gClockedData[mLane] == NULL) {
+                ESP_LOGE("FastLED", "I2S: no memory for a %d byte clocked strip, skipping it", bytes);
+                gClockedLen[mLane] = 0;
+                return;
+            }
+        }
+
+        uint8_t s0 = pixels.getScale0(), s1 = pixels.getScale1(), s2 = pixels.getScale2();
+#if FASTLED_APA102_HDR == 1
+        // -- Brightness is chosen per pixel, by loadAndScaleAPA102HDR
+        (void)s0; (void)s1; (void)s2;
+#elif FASTLED_USE_GLOBAL_BRIGHTNESS == 1
+        const uint16_t maxBrightness = 0x1F;
+        uint16_t brightness = ((((uint16_t)max(max(s0, s1), s2) + 1) * maxBrightness - 1) >> 8) + 1;
+        s0 = (maxBrightness * s0 + (brightness >> 1)) / brightness;
+        s1 = (maxBrightness * s1 + (brightness >> 1)) / brightness;
+        s2 = (maxBrightness * s2 + (brightness >> 1)) / brightness;
+#else
+        const uint8_t brightness = 0x1F;
+#endif
+
+        uint8_t * p = gClockedData[mLane];
+        *p++ = 0; *p++ = 0; *p++ = 0; *p++ = 0;
+        while (pixels.has(1)) {
+#if FASTLED_APA102_HDR == 1
+            p[0] = 0xE0 | pixels.loadAndScaleAPA102HDR(p[1], p[2], p[3]);
+            p += 4;
+#else
+            *p++ = 0xE0 | brightness;
+            *p++ = pixels.loadAndScale0(0, s0);
+            *p++ = pixels.loadAndScale1(0, s1);
+            *p++ = pixels.loadAndScale2(0, s2);
+#endif
+            pixels.stepDithering();
+            pixels.advanceData();
+        }
+        for (int i = 0; i < endWords; i++) {
+            *p++ = SK9822 ? 0x00 : 0xFF; *p++ = 0; *p++ = 0; *p++ = 0;
+        }
+
+        gClockedLen[mLane] = bytes;
+    }
+
+    static void outputPin(int pin, int lane)
+    {
+        PIN_FUNC_SELECT(GPIO_PIN_MUX_REG[pin], PIN_FUNC_GPIO);
+        gpio_set_direction(gpio_num_t(pin), (gpio_mode_t)GPIO_MODE_DEF_OUTPUT);
+        gpio_matrix_out(pin, gClockedBasePin + lane, false, false);
+    }
+
+    static void i2sClockedInit()
+    {
+        if (gClockedI2S) {
+            if (gClockedDivN != CLOCK_DIV_N) {
+                ESP_LOGE("FastLED", "I2S: clocked strips must share clock rate (divider %d)", gClockedDivN);
+            }
+            return;
+        }
+
+        int interruptSource;
+        gClockedI2S = i2sEnable(FASTLED_I2S_CLOCKED_DEVICE, interruptSource, gClockedBasePin);
+        i2sConfigure(gClockedI2S, CLOCK_DIV_N, 1, 0);
+        gClockedDivN = CLOCK_DIV_N;
+
+        allocateBuffers();
+
+        ESP_ERROR_CHECK(
+            esp_intr_alloc(interruptSource, 0, &interruptHandler, 0, &gClockedIntr)
+        );
+        gClockedSem = xSemaphoreCreateBinary();
+
+        memset(gClockedRow, 0, sizeof(gClockedRow));
+    }
+
+    // -- Allocate the two DMA buffers and link them into a ring
+    //    If there is not enough DMA memory, neither is kept and
+    //    startFrame() tries again.
+    static bool allocateBuffers()
+    {
+        for (int i = 0; i < 2; i++) {
+            gClockedBuffers[i] = i2sAllocateDMABuffer(I2S_CLOCKED_BUFFER_WORDS * sizeof(uint32_t));
+        }
+        if (gClockedBuffers[0] == NULL || gClockedBuffers[1] == NULL) {
+            ESP_LOGE("FastLED", "I2S: no DMA memory for the clocked buffers, dropping the frame");
+            for (int i = 0; i < 2; i++) {
+                i2sFreeDMABuffer(gClockedBuffers[i]);
+                gClockedBuffers[i] = NULL;
+            }
+            return false;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            DMABuffer * b = gClockedBuffers[i];
+            b->descriptors[b->numDescriptors - 1].qe.stqe_next = & (gClockedBuffers[1 - i]->descriptors[0]);
+        }
+        return true;
+    }
+
+    // -- Encode bytes [pos, pos + FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER)
+    //    of every strip into the buffer
+    static IRAM_ATTR void fillBuffer(DMABuffer * b, int pos)
+    {
+        uint32_t * buf = (uint32_t *) b->buffer;
+        for (int n = 0; n < FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER; n++, pos++) {
+            for (int i = 0; i < gNumClocked; i++) {
+                gClockedRow[i] = (pos < gClockedLen[i]) ? gClockedData[i][pos] : 0;
+            }
+
+            // -- Most significant bit first
+            transpose24(gClockedRow, gClockedBits);
+            for (int bitnum = 0; bitnum < 8; bitnum++) {
+                *buf++ = gClockedBits[bitnum];
+                *buf++ = gClockedBits[bitnum] | I2S_CLOCKED_CLOCK_BIT;
+            }
+        }
+        *buf = 0;
+    }
+
+    // -- Fill the next buffer in the ring with the next piece of the
+    //    frame, or past the end of it, with silence: no clock at all
+    static IRAM_ATTR void fillNext()
+    {
+        DMABuffer * b = gClockedBuffers[gClockedCur];
+        if (gClockedPos < gClockedBytes) {
+            fillBuffer(b, gClockedPos);
+            gClockedPos += FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER;
+            gClockedDataBuffers++;
+        } else {
+            memset(b->buffer, 0, I2S_CLOCKED_BUFFER_WORDS * sizeof(uint32_t));
+        }
+        gClockedCur = 1 - gClockedCur;
+    }
+
+    // -- Send the strips
+    //    Strips that were not shown send zeros, which leaves them as
+    //    they are.
+    static void startFrame()
+    {
+        gNumClockedShown = 0;
+        gClockedBytes = 0;
+        for (int i = 0; i < gNumClocked; i++) {
+            if (gClockedLen[i] > gClockedBytes) gClockedBytes = gClockedLen[i];
+        }
+        if (gClockedBytes == 0) return;
+        if (gClockedBuffers[0] == NULL && ! allocateBuffers()) {
+            clearStrips();
+            return;
+        }
+
+        gClockedPos = 0;
+        gClockedCur = 0;
+        gClockedDataBuffers = 0;
+        gClockedBuffersSent = 0;
+        fillNext();
+        fillNext();
+
+        i2s_dev_t * i2s = gClockedI2S;
+        xSemaphoreTake(gClockedSem, 0);
+        i2sReset(i2s);
+        i2s->lc_conf.val = I2S_OUT_DATA_BURST_EN | I2S_OUTDSCR_BURST_EN;
+        i2s->out_link.addr = (uint32_t)(uintptr_t) & (gClockedBuffers[0]->descriptors[0]);
+        i2s->out_link.start = 1;
+        i2s->int_clr.val = i2s->int_raw.val;
+        i2s->int_ena.val = 0;
+        i2s->int_ena.out_eof = 1;
+        esp_intr_enable(gClockedIntr);
+        i2s->conf.tx_start = 1;
+        gClockedSending = true;
+    }
+
+    // -- Wait for the frame being sent, if any
+    //    Allows twice the time the frame takes on the wire, plus 10ms;
+    //    if the interrupt handler has not finished by then, the frame
+    //    is stopped where it is.
+    static void waitFrame()
+    {
+        if ( ! gClockedSending) return;
+
+        uint32_t words = (gClockedDataBuffers + 1) * I2S_CLOCKED_BUFFER_WORDS;
+        uint32_t us = (uint64_t) words * gClockedDivN * 1000000 / I2S_BASE_CLK;
+        if (xSemaphoreTake(gClockedSem, pdMS_TO_TICKS(us / 500 + 10) + 1) != pdTRUE) {
+            ESP_LOGE("FastLED", "I2S: clocked frame did not finish, stopping it");
+        }
+
+        esp_intr_disable(gClockedIntr);
+        i2sReset(gClockedI2S);
+        gClockedI2S->conf.tx_start = 0;
+        gClockedSending = false;
+        clearStrips();
+    }
+
+    // -- Strips that are not shown again send zeros next time
+    static void clearStrips()
+    {
+        for (int i = 0; i < gNumClocked; i++) {
+            gClockedLen[i] = 0;
+        }
+    }
+
+    // -- A buffer has been read into the FIFO: refill it, or after the
+    //    silent buffer that follows the last piece, stop
+    static IRAM_ATTR void interruptHandler(void * arg)
+    {
+        i2s_dev_t * i2s = gClockedI2S;
+        if ( ! i2s->int_st.out_eof) return;
+        i2s->int_clr.val = i2s->int_raw.val;
+
+        gClockedBuffersSent++;
+        if (gClockedBuffersSent > gClockedDataBuffers) {
+            i2s->int_ena.out_eof = 0;
+            i2s->conf.tx_start = 0;
+
+            portBASE_TYPE HPTaskAwoken = 0;
+            xSemaphoreGiveFromISR(gClockedSem, &HPTaskAwoken);
+            if (HPTaskAwoken == pdTRUE) portYIELD_FROM_ISR();
+            return;
+        }
+        fillNext();
+    }
+};
+
+FASTLED_NAMESPACE_END
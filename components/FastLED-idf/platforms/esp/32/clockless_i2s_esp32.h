@@ -45,24 +45,84 @@
  *
  *   2. Tranpose the array so that it is 3 X 8 X 24 bits. The hardware
  *      wants the data in 32-bit chunks, so the actual form is 3 X 8 X
- *      32, with the low 8 bits unused.
+ *      32, with the low 8 bits unused. transpose24() reads the 24
+ *      bytes of a color channel as six words and produces the eight
+ *      32-bit words directly.
  *
  *   3. Take each group of 24 parallel bits and "expand" them into a
  *      pattern according to the encoding. For example, with a 8MHz
  *      data clock, each data bit turns into 10 I2s pulses, so 24
  *      parallel data bits turn into 10 X 24 pulses.
  *
- * We send data to the I2S peripheral using the DMA interface. We use
- * two DMA buffers, so that we can fill one buffer while the other
- * buffer is being sent. Each DMA buffer holds the fully-expanded
- * pulse pattern for one pixel on up to 24 strips. The exact amount of
- * memory required depends on the number of color channels and the
- * number of pulses used to encode each bit.
+ * RGBW chipsets (e.g., SK6812RGBWController) add a fourth color
+ * channel, white, which is computed in step 1 from the scaled pixel.
+ * Since all strips must use the same chipset, either every strip
+ * sends four channels or none does.
+ *
+ * We send data to the I2S peripheral using the DMA interface. By
+ * default we use two DMA buffers, so that we can fill one buffer while
+ * the other buffer is being sent. Each DMA buffer holds the
+ * fully-expanded pulse pattern for one pixel on up to 24 strips. The
+ * exact amount of memory required depends on the number of color
+ * channels and the number of pulses used to encode each bit.
  *
  * We get an interrupt each time a buffer is sent; we then fill that
  * buffer while the next one is being sent. The DMA interface allows
  * us to configure the buffers as a circularly linked list, so that it
  * can automatically start on the next buffer.
+ *
+ * With long strips that is a lot of interrupts, and a late one stalls
+ * the stream. Two defines trade memory for slack:
+ *
+ *   #define FASTLED_I2S_PIXELS_PER_BUFFER 8
+ *   #define FASTLED_I2S_NUM_DMA_BUFFERS 4
+ *
+ * The first makes each buffer hold several pixel rows, so there is one
+ * interrupt per that many pixels. The second makes the ring longer, so
+ * the interrupt can be that many buffers late before the DMA catches
+ * up with us. A WS2812 row is 960 bytes of DMA memory (1280 for RGBW),
+ * so the example above takes 30KB.
+ *
+ * FULL FRAME: For static or slowly changing content, the whole frame
+ * can be encoded up front into one chain of DMA descriptors, which the
+ * hardware then streams with no work at all in the interrupt handler:
+ *
+ *   #define FASTLED_I2S_FULL_FRAME 1
+ *
+ * show() encodes the frame and returns as soon as the DMA is started,
+ * so the CPU can render the next frame while this one goes out; the
+ * next show() waits for it to finish. Add
+ *
+ *   #define FASTLED_I2S_FULL_FRAME_LOOP 1
+ *
+ * to have the hardware keep replaying the frame until the next show().
+ * The frame starts with enough low rows for the LEDs to latch, so a
+ * replay is just the same data sent again. Every pixel of the longest
+ * strip takes one row of DMA memory, whatever the number of strips:
+ * 32 bytes per pulse of a bit per color channel, 960 bytes for a WS2812
+ * and 1280 for an SK6812 RGBW. The latch adds about ten rows more.
+ * The ESP32 cannot DMA from PSRAM, so 100 pixels per strip (about
+ * 106KB for WS2812) is already a large share of its internal RAM.
+ *
+ * ASYNCHRONOUS SHOW: Normally the interrupt handler reads the pixels
+ * straight out of the application's CRGB arrays, so show() has to wait
+ * until the frame is sent. Define
+ *
+ *   #define FASTLED_I2S_ASYNC_SHOW 1
+ *
+ * to have show() scale and dither each strip into a private snapshot
+ * and return as soon as the frame is started. There are two snapshots
+ * per strip, so the next show() can fill one while the other is still
+ * being sent; it only waits before starting its own frame. To find out
+ * when a frame is done, call i2sWaitForShowDone(), or register a
+ * function with i2sSetShowDoneCallback(), which runs in the interrupt
+ * handler. This does not apply to FULL FRAME mode, which already
+ * returns early.
+ *
+ * The frame is sent once every controller has been shown, which is
+ * what FastLED.show() does. FastLED.flushLeds() sends only some of the
+ * controllers: the others get no pulses at all, so their strips keep
+ * what they are showing.
  */
 /*
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -108,6 +168,7 @@ extern "C" {
 #include "driver/gpio.h"
 #include "driver/periph_ctrl.h"
 #include "esp32/rom/lldesc.h"
+#include "xtensa/hal.h"
 
 #include "esp_log.h"
     
@@ -117,12 +178,16 @@ extern "C" {
 
 __attribute__ ((always_inline)) inline static uint32_t __clock_cycles() {
     uint32_t cyc;
+#ifdef __XTENSA__
     __asm__ __volatile__ ("rsr %0,ccount":"=a" (cyc));
+#else
+    cyc = xthal_get_ccount();
+#endif
     return cyc;
 }
 
 #define FASTLED_HAS_CLOCKLESS 1
-#define NUM_COLOR_CHANNELS 3
+#define MAX_COLOR_CHANNELS 4
 
 // -- Choose which I2S device to use
 #ifndef I2S_DEVICE
@@ -146,6 +211,12 @@ static CLEDController * gControllers[FASTLED_I2S_MAX_CONTROLLERS];
 static int gNumControllers = 0;
 static int gNumStarted = 0;
 
+// -- Inside a beginFlush()/flush() pair: hold the frame until flush()
+static bool gFlushPending = false;
+
+// -- Make sure we can't call show() too quickly
+static CMinWait<55> gWait;
+
 // -- Global semaphore for the whole show process
 //    Semaphore is not given until all data has been sent
 static xSemaphoreHandle gTX_sem = NULL;
@@ -163,38 +234,344 @@ static i2s_dev_t * i2s;
 static int i2s_base_pin_index;
 
 // --- I2S DMA buffers
+//    A DMA descriptor can only point to 4095 bytes, so a buffer with
+//    several pixel rows may need a chain of them. Only the last one
+//    raises the end-of-frame interrupt.
+#define DMA_MAX_DESCRIPTOR_BYTES 4092
+
 struct DMABuffer {
-    lldesc_t descriptor;
+    lldesc_t * descriptors;
+    int numDescriptors;
     uint8_t * buffer;
 };
 
-#define NUM_DMA_BUFFERS 2
+// -- Pixel rows in each DMA buffer
+#ifndef FASTLED_I2S_PIXELS_PER_BUFFER
+#define FASTLED_I2S_PIXELS_PER_BUFFER 1
+#endif
+
+// -- DMA buffers in the ring
+#ifndef FASTLED_I2S_NUM_DMA_BUFFERS
+#define FASTLED_I2S_NUM_DMA_BUFFERS 2
+#endif
+
+#define NUM_DMA_BUFFERS FASTLED_I2S_NUM_DMA_BUFFERS
 static DMABuffer * dmaBuffers[NUM_DMA_BUFFERS];
 
-// -- Bit patterns
-//    For now, we require all strips to be the same chipset, so these
-//    are global variables.
+// -- Strips that the leading "always high" pulses are currently
+//    enabled for in each row of each buffer (see empty() and fillBuffer())
+static uint32_t gBufferMask[NUM_DMA_BUFFERS][FASTLED_I2S_PIXELS_PER_BUFFER];
 
-static int      gPulsesPerBit = 0;
-static uint32_t gOneBit[40] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-static uint32_t gZeroBit[40]  = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
+// -- Color channels per pixel
+//    For now, we require all strips to be the same chipset, so this
+//    is a global variable. The pulse patterns are compile time
+//    constants of the controller (see PULSES_PER_BIT).
+static int      gNumColorChannels = 3;
 
 // -- Counters to track progress
 static int gCurBuffer = 0;
 static bool gDoneFilling = false;
-static int ones_for_one;
-static int ones_for_zero;
+static int gDataBuffers = 0;
+static int gBuffersSent = 0;
+
+// -- Encode the whole frame into one descriptor chain
+#ifndef FASTLED_I2S_FULL_FRAME
+#define FASTLED_I2S_FULL_FRAME 0
+#endif
+
+// -- Replay the whole frame until the next show
+#ifndef FASTLED_I2S_FULL_FRAME_LOOP
+#define FASTLED_I2S_FULL_FRAME_LOOP 0
+#endif
+
+// -- Snapshot the pixels and return from show() right away
+#ifndef FASTLED_I2S_ASYNC_SHOW
+#define FASTLED_I2S_ASYNC_SHOW 0
+#endif
+
+#define I2S_SNAPSHOT (FASTLED_I2S_ASYNC_SHOW && ! FASTLED_I2S_FULL_FRAME)
+
+// -- Called when a frame has been sent
+typedef void (*i2s_show_done_fn)(void * arg);
+static i2s_show_done_fn gShowDoneFn = NULL;
+static void * gShowDoneArg = NULL;
+
+// -- A frame was started and nobody has waited for it yet
+static bool gShowPending = false;
+
+// -- The frame, its size in rows, and whether it is being sent
+static DMABuffer * gFrame = NULL;
+static int gFrameRows = 0;
+static bool gFrameRunning = false;
+
+// -- Length of one data bit, for sizing the latch
+static uint32_t gNsPerBit = 0;
 
 // -- Temp buffers for pixels and bits being formatted for DMA
-static uint8_t gPixelRow[NUM_COLOR_CHANNELS][32];
-static uint8_t gPixelBits[NUM_COLOR_CHANNELS][8][4];
+//    Each row is read as words by transpose24(), so it must be aligned
+static uint8_t gPixelRow[MAX_COLOR_CHANNELS][32] __attribute__ ((aligned (4)));
+static uint32_t gPixelBits[8];
 static int CLOCK_DIVIDER_N;
 static int CLOCK_DIVIDER_A;
 static int CLOCK_DIVIDER_B;
 
-template <int DATA_PIN, int T1, int T2, int T3, EOrder RGB_ORDER = RGB, int XTRA0 = 0, bool FLIP = false, int WAIT_TIME = 5>
+// -- Wait for the frame that is being sent to finish
+//    Returns false if it did not finish within the given time.
+static bool i2sWaitForShowDone(TickType_t ticks = portMAX_DELAY)
+{
+    if ( ! gShowPending) return true;
+    if (xSemaphoreTake(gTX_sem, ticks) != pdTRUE) return false;
+    xSemaphoreGive(gTX_sem);
+    gShowPending = false;
+    gWait.mark();
+    return true;
+}
+
+// -- Register a function to call when a frame has been sent
+//    It runs in the interrupt handler. Pass NULL to remove it.
+static inline void i2sSetShowDoneCallback(i2s_show_done_fn fn, void * arg)
+{
+    gShowDoneFn = NULL;
+    gShowDoneArg = arg;
+    gShowDoneFn = fn;
+}
+
+// -- Free a DMA buffer and its descriptors
+static void i2sFreeDMABuffer(DMABuffer * b)
+{
+    if (b == NULL) return;
+    heap_caps_free(b->descriptors);
+    heap_caps_free(b->buffer);
+    heap_caps_free(b);
+}
+
+// -- Allocate a DMA buffer and the chain of descriptors that covers it
+//    Returns NULL if there is not enough DMA memory.
+static DMABuffer * i2sAllocateDMABuffer(int bytes)
+{
+    DMABuffer * b = (DMABuffer *)heap_caps_malloc(sizeof(DMABuffer), MALLOC_CAP_DMA);
+    if (b == NULL) return NULL;
+    
+    b->numDescriptors = (bytes + DMA_MAX_DESCRIPTOR_BYTES - 1) / DMA_MAX_DESCRIPTOR_BYTES;
+    b->buffer = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
+    b->descriptors = (lldesc_t *)heap_caps_malloc(b->numDescriptors * sizeof(lldesc_t), MALLOC_CAP_DMA);
+    if (b->buffer == NULL || b->descriptors == NULL) {
+        i2sFreeDMABuffer(b);
+        return NULL;
+    }
+    memset(b->buffer, 0, bytes);
+    
+    for (int i = 0; i < b->numDescriptors; i++) {
+        int offset = i * DMA_MAX_DESCRIPTOR_BYTES;
+        int len = bytes - offset;
+        if (len > DMA_MAX_DESCRIPTOR_BYTES) len = DMA_MAX_DESCRIPTOR_BYTES;
+        
+        lldesc_t * d = & b->descriptors[i];
+        d->length = len;
+        d->size = len;
+        d->owner = 1;
+        d->sosf = 1;
+        d->buf = b->buffer + offset;
+        d->offset = 0;
+        d->empty = 0;
+        d->eof = (i == b->numDescriptors - 1) ? 1 : 0;
+        d->qe.stqe_next = (i == b->numDescriptors - 1) ? 0 : & b->descriptors[i+1];
+    }
+    
+    return b;
+}
+
+// -- Reset the device, its DMA and its FIFO
+static void i2sReset(i2s_dev_t * i2s)
+{
+    const unsigned long lc_conf_reset_flags = I2S_IN_RST_M | I2S_OUT_RST_M | I2S_AHBM_RST_M | I2S_AHBM_FIFO_RST_M;
+    i2s->lc_conf.val |= lc_conf_reset_flags;
+    i2s->lc_conf.val &= ~lc_conf_reset_flags;
+    
+    const uint32_t conf_reset_flags = I2S_RX_RESET_M | I2S_RX_FIFO_RESET_M | I2S_TX_RESET_M | I2S_TX_FIFO_RESET_M;
+    i2s->conf.val |= conf_reset_flags;
+    i2s->conf.val &= ~conf_reset_flags;
+}
+
+static void i2sReset_DMA(i2s_dev_t * i2s)
+{
+    i2s->lc_conf.in_rst=1; i2s->lc_conf.in_rst=0;
+    i2s->lc_conf.out_rst=1; i2s->lc_conf.out_rst=0;
+}
+
+static void i2sReset_FIFO(i2s_dev_t * i2s)
+{
+    i2s->conf.rx_fifo_reset=1; i2s->conf.rx_fifo_reset=0;
+    i2s->conf.tx_fifo_reset=1; i2s->conf.tx_fifo_reset=0;
+}
+
+// -- Turn on I2S device 0 or 1
+//    Returns its registers, and sets the interrupt source and the
+//    signal index of its first parallel output.
+static i2s_dev_t * i2sEnable(int device, int & interruptSource, int & base_pin_index)
+{
+    i2s_dev_t * i2s;
+    if (device == 0) {
+        i2s = &I2S0;
+        periph_module_enable(PERIPH_I2S0_MODULE);
+        interruptSource = ETS_I2S0_INTR_SOURCE;
+        base_pin_index = I2S0O_DATA_OUT0_IDX;
+    } else {
+        i2s = &I2S1;
+        periph_module_enable(PERIPH_I2S1_MODULE);
+        interruptSource = ETS_I2S1_INTR_SOURCE;
+        base_pin_index = I2S1O_DATA_OUT0_IDX;
+    }
+    
+    // -- Reset everything
+    i2sReset(i2s);
+    i2sReset_DMA(i2s);
+    i2sReset_FIFO(i2s);
+    
+    return i2s;
+}
+
+// -- Set up 24-bit parallel output from DMA
+//    The data clock is 80MHz/(div_n + div_b/div_a).
+static void i2sConfigure(i2s_dev_t * i2s, int div_n, int div_a, int div_b)
+{
+    i2s->conf.tx_msb_right = 1;
+    i2s->conf.tx_mono = 0;
+    i2s->conf.tx_short_sync = 0;
+    i2s->conf.tx_msb_shift = 0;
+    i2s->conf.tx_right_first = 1; // 0;//1;
+    i2s->conf.tx_slave_mod = 0;
+    
+    // -- Set parallel mode
+    i2s->conf2.val = 0;
+    i2s->conf2.lcd_en = 1;
+    i2s->conf2.lcd_tx_wrx2_en = 0; // 0 for 16 or 32 parallel output
+    i2s->conf2.lcd_tx_sdx2_en = 0; // HN
+    
+    // -- Set up the clock rate and sampling
+    i2s->sample_rate_conf.val = 0;
+    i2s->sample_rate_conf.tx_bits_mod = 32; // Number of parallel bits/pins
+    i2s->sample_rate_conf.tx_bck_div_num = 1;
+    i2s->clkm_conf.val = 0;
+    i2s->clkm_conf.clka_en = 0;
+    
+    // -- Data clock is computed as Base/(div_num + (div_b/div_a))
+    //    Base is 80Mhz, so 80/(10 + 0/1) = 8Mhz
+    //    One cycle is 125ns
+    i2s->clkm_conf.clkm_div_a = div_a;
+    i2s->clkm_conf.clkm_div_b = div_b;
+    i2s->clkm_conf.clkm_div_num = div_n;
+    
+    i2s->fifo_conf.val = 0;
+    i2s->fifo_conf.tx_fifo_mod_force_en = 1;
+    i2s->fifo_conf.tx_fifo_mod = 3;  // 32-bit single channel data
+    i2s->fifo_conf.tx_data_num = 32; // fifo length
+    i2s->fifo_conf.dscr_en = 1;      // fifo will use dma
+    
+    i2s->conf1.val = 0;
+    i2s->conf1.tx_stop_en = 0;
+    i2s->conf1.tx_pcm_bypass = 1;
+    
+    i2s->conf_chan.val = 0;
+    i2s->conf_chan.tx_chan_mod = 1; // Mono mode, with tx_msb_right = 1, everything goes to right-channel
+    
+    i2s->timing.val = 0;
+}
+
+/** Transpose an 8x8 bit matrix in place
+ *  Byte i of x (rows 0-3) and y (rows 4-7) is row i. From
+ *  Hacker's Delight, section 7-3.
+ */
+__attribute__ ((always_inline)) inline static void transpose8x8(uint32_t & x, uint32_t & y)
+{
+    uint32_t t;
+    
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+    
+    t = (x ^ (x >>14)) & 0x0000CCCC;  x = x ^ t ^ (t <<14);
+    t = (y ^ (y >>14)) & 0x0000CCCC;  y = y ^ t ^ (t <<14);
+    
+    t = (x ^ (y << 4)) & 0xF0F0F0F0;
+    x = x ^ t;
+    y = y ^ (t >> 4);
+}
+
+/** Gather byte c of a, b and c into bytes 1, 2 and 3 of out_c
+ *  A 4x4 byte transpose with a zero first row.
+ */
+__attribute__ ((always_inline)) inline static void gather3(uint32_t a, uint32_t b, uint32_t c,
+                                                           uint32_t & out0, uint32_t & out1, uint32_t & out2, uint32_t & out3)
+{
+    uint32_t a_even = (a & 0x00FF00FF) << 8;
+    uint32_t a_odd  =  a & 0xFF00FF00;
+    uint32_t bc_even = (b & 0x00FF00FF) | ((c & 0x00FF00FF) << 8);
+    uint32_t bc_odd  = ((b >> 8) & 0x00FF00FF) | (c & 0xFF00FF00);
+    
+    out0 = (a_even & 0xFFFF) | (bc_even << 16);
+    out1 = (a_odd & 0xFFFF)  | (bc_odd << 16);
+    out2 = (a_even >> 16)    | (bc_even & 0xFFFF0000);
+    out3 = (a_odd >> 16)     | (bc_odd & 0xFFFF0000);
+}
+
+/** Transpose 24 bytes into 8 bit planes
+ *
+ *  bits[k] gets bit 7-k of pixels[i] in bit i+8, for i = 0..23.
+ *  Each group of 8 bytes is an 8x8 bit matrix held in two words,
+ *  with byte i in row i, which is transposed in place. Row c of
+ *  the result holds bit c of all 8 bytes; a 4x4 byte transpose
+ *  across the three groups then gathers each row into its plane.
+ */
+static IRAM_ATTR void transpose24(const uint8_t * pixels, uint32_t * bits)
+{
+    const uint32_t * words = (const uint32_t *) __builtin_assume_aligned(pixels, 4);
+    uint32_t x0 = words[0], y0 = words[1];
+    uint32_t x1 = words[2], y1 = words[3];
+    uint32_t x2 = words[4], y2 = words[5];
+    
+    transpose8x8(x0, y0);
+    transpose8x8(x1, y1);
+    transpose8x8(x2, y2);
+    
+    gather3(x0, x1, x2, bits[7], bits[6], bits[5], bits[4]);
+    gather3(y0, y1, y2, bits[3], bits[2], bits[1], bits[0]);
+}
+
+// -- Largest pulse length, in CPU cycles, from i down, that divides
+//    a, b and c to within precision cycles
+static constexpr int i2sPgcd(int i, int precision, int a, int b, int c)
+{
+    return (i <= 1) ? 1 :
+        ((a%i <= precision && b%i <= precision && c%i <= precision) ? i : i2sPgcd(i-1, precision, a, b, c));
+}
+
+// -- Pulse length for T1, T2 and T3: the first one, allowing more and
+//    more imprecision, that is not a single cycle and does not need
+//    more than I2S_MAX_PULSE_PER_BIT pulses per bit
+static constexpr int i2sPulseCycles(int smallest, int precision, int a, int b, int c)
+{
+    return (i2sPgcd(smallest, precision, a, b, c) == 1 ||
+            (a/i2sPgcd(smallest, precision, a, b, c) +
+             b/i2sPgcd(smallest, precision, a, b, c) +
+             c/i2sPgcd(smallest, precision, a, b, c)) > I2S_MAX_PULSE_PER_BIT)
+        ? i2sPulseCycles(smallest, precision+1, a, b, c)
+        : i2sPgcd(smallest, precision, a, b, c);
+}
+
+template <int DATA_PIN, int T1, int T2, int T3, EOrder RGB_ORDER = RGB, int XTRA0 = 0, bool FLIP = false, int WAIT_TIME = 5, EWhiteMode WHITE = RGBW_NONE>
 class ClocklessController : public CPixelLEDController<RGB_ORDER>
 {
+    // -- The pulse pattern, worked out at compile time so that the
+    //    encoding loops in fillRow() have constant bounds
+    enum {
+        PULSE_CYCLES   = i2sPulseCycles((T1 > T2 ? (T2 > T3 ? T3 : T2) : (T1 > T3 ? T3 : T1)), 0, T1, T2, T3),
+        PULSES_PER_BIT = T1/PULSE_CYCLES + T2/PULSE_CYCLES + T3/PULSE_CYCLES,
+        ONES_FOR_ONE   = T1/PULSE_CYCLES + T2/PULSE_CYCLES,
+        ONES_FOR_ZERO  = T1/PULSE_CYCLES,
+        COLOR_CHANNELS = (WHITE == RGBW_NONE) ? 3 : 4,
+        ROW_WORDS      = 8 * COLOR_CHANNELS * PULSES_PER_BIT
+    };
+    
     // -- Store the GPIO pin
     gpio_num_t     mPin;
     
@@ -204,8 +581,20 @@ class ClocklessController : public CPixelLEDController<RGB_ORDER>
     // -- Save the pixel controller
     PixelController<RGB_ORDER> * mPixels;
     
-    // -- Make sure we can't call show() too quickly
-    CMinWait<55>   mWait;
+    // -- Snapshots of the scaled pixels, for FASTLED_I2S_ASYNC_SHOW
+    //    showPixels() fills mSnapshot[mBack]; the other one is sent,
+    //    from mSnapPos up to mSnapEnd.
+    uint8_t *      mSnapshot[2];
+    int            mSnapshotBytes[2];
+    int            mSnapshotLen[2];
+    int            mBack;
+    int            mSnapPos;
+    int            mSnapEnd;
+    bool           mShown;
+    
+    // -- There was no memory for the snapshot: this frame is sent
+    //    straight from mPixels, and show() waits for it
+    bool           mDirect;
 
  public:
 
@@ -215,7 +604,17 @@ class ClocklessController : public CPixelLEDController<RGB_ORDER>
         
         // -- Allocate space to save the pixel controller
         //    during parallel output
-        mPixels = (PixelController<RGB_ORDER> *) malloc(sizeof(PixelController<RGB_ORDER>));
+        //    Zeroed, so that a strip that has not been shown yet has no
+        //    data to send if other strips are flushed without it.
+        mPixels = (PixelController<RGB_ORDER> *) calloc(1, sizeof(PixelController<RGB_ORDER>));
+        
+        mSnapshot[0] = mSnapshot[1] = NULL;
+        mSnapshotBytes[0] = mSnapshotBytes[1] = 0;
+        mSnapshotLen[0] = mSnapshotLen[1] = 0;
+        mBack = 0;
+        mSnapPos = mSnapEnd = 0;
+        mShown = false;
+        mDirect = false;
         
         gControllers[gNumControllers] = this;
         int my_index = gNumControllers;
@@ -236,24 +635,37 @@ class ClocklessController : public CPixelLEDController<RGB_ORDER>
     }
     
     virtual uint16_t getMaxRefreshRate() const { return 400; }
+
+    // -- Start a batch of output
+    //    Controllers shown from now on are held until flush()
+    virtual void beginFlush() { gFlushPending = true; }
+
+    // -- Send the controllers shown since beginFlush()
+    //    Called once for every controller in the batch, so only the
+    //    first call does anything.
+    virtual void flush()
+    {
+        gFlushPending = false;
+        if (gNumStarted > 0) {
+            startShow(false);
+        }
+    }
     
-protected:
-   
-   static int pgcd(int smallest,int precision,int a,int b,int c)
+    virtual bool holdsUntilFlush() const { return true; }
+    
+    // -- Wait for the frame started by flush()
+    //    With FASTLED_I2S_ASYNC_SHOW or FASTLED_I2S_FULL_FRAME, show()
+    //    returns early anyway.
+    virtual void waitFlush()
     {
-        int pgc_=1;
-        for( int i=smallest;i>0;i--)
-        {
-            
-            if( a%i<=precision && b%i<=precision && c%i<=precision)
-            {
-                pgc_=i;
-                break;
-            }
+        if ( ! I2S_SNAPSHOT && ! FASTLED_I2S_FULL_FRAME && gShowPending) {
+            i2sWaitForShowDone();
+            i2sStop();
         }
-        return pgc_;
     }
     
+protected:
+   
     /** Compute pules/bit patterns
      *
      *  This is Yves Bazin's mad code for computing the pulse pattern
@@ -267,47 +679,21 @@ protected:
     static void initBitPatterns()
     {
         // Precompute the bit patterns based on the I2S sample rate
-        // println("Setting up fastled using I2S");
 
         // -- First, convert back to ns from CPU clocks
         uint32_t T1ns = ESPCLKS_TO_NS(T1);
         uint32_t T2ns = ESPCLKS_TO_NS(T2);
         uint32_t T3ns = ESPCLKS_TO_NS(T3);
-        
-        // print("T1 = "); print(T1); print(" ns "); println(T1ns);
-        // print("T2 = "); print(T2); print(" ns "); println(T2ns);
-        // print("T3 = "); print(T3); print(" ns "); println(T3ns);
+        gNsPerBit = T1ns + T2ns + T3ns;
         
         /*
          We calculate the best pcgd to the timing
          ie
          WS2811 77 77 154 => 1  1 2 => nb pulses= 4
          WS2812 60 150 90 => 2 5 3 => nb pulses=10
+         This is done at compile time, see PULSE_CYCLES.
          */
-        int smallest=0;
-        if (T1>T2)
-            smallest=T2;
-        else
-            smallest=T1;
-        if(smallest>T3)
-            smallest=T3;
         double freq=(double)1/(double)(T1ns + T2ns + T3ns);
-        // printf("chipset frequency:%f Khz\n", 1000000L*freq);
-       // printf("smallest %d\n",smallest);
-        int pgc_=1;
-        int precision=0;
-        pgc_=pgcd(smallest,precision,T1,T2,T3);
-        //printf("%f\n",I2S_MAX_CLK/(1000000000L*freq));
-        while(pgc_==1 ||  (T1/pgc_ +T2/pgc_ +T3/pgc_)>I2S_MAX_PULSE_PER_BIT) //while(pgc_==1 ||  (T1/pgc_ +T2/pgc_ +T3/pgc_)>I2S_MAX_CLK/(1000000000L*freq))
-        {
-            precision++;
-            pgc_=pgcd(smallest,precision,T1,T2,T3);
-            //printf("%d %d\n",pgc_,(a+b+c)/pgc_);
-        }
-        pgc_=pgcd(smallest,precision,T1,T2,T3);
-        // printf("pgcd %d precision:%d\n",pgc_,precision);
-        // printf("nb pulse per bit:%d\n",T1/pgc_ +T2/pgc_ +T3/pgc_);
-        gPulsesPerBit=(int)T1/pgc_ +(int)T2/pgc_ +(int)T3/pgc_;
         /*
          we calculate the duration of one pulse nd htre base frequency of the led
          ie WS2812B F=1/(250+625+375)=800kHz or 1250ns
@@ -316,8 +702,7 @@ protected:
          
          */
 
-        freq=1000000000L*freq*gPulsesPerBit;
-        // printf("needed frequency (nbpiulse per bit)*(chispset frequency):%f Mhz\n",freq/1000000);
+        freq=1000000000L*freq*PULSES_PER_BIT;
         
         /*
          we do calculate the needed N a and b
@@ -338,7 +723,6 @@ protected:
         {
             for(b=0;b<a;b++)
             {
-                //printf("%d %d %f %f %f\n",b,a,v,(double)v*(double)a,fabsf(v-(double)b/a));
                 if(fabsf(v-(double)b/a) <= prec/2)
                     break;
             }
@@ -366,75 +750,14 @@ protected:
             CLOCK_DIVIDER_N++;
         }
         
-        //printf("%d %d %f %f %d\n",CLOCK_DIVIDER_B,CLOCK_DIVIDER_A,(double)CLOCK_DIVIDER_B/CLOCK_DIVIDER_A,v,CLOCK_DIVIDER_N);
-        //printf("freq %f %f\n",freq,I2S_BASE_CLK/(CLOCK_DIVIDER_N+(double)CLOCK_DIVIDER_B/CLOCK_DIVIDER_A));
         freq=1/(CLOCK_DIVIDER_N+(double)CLOCK_DIVIDER_B/CLOCK_DIVIDER_A);
         freq=freq*I2S_BASE_CLK;
-        // printf("calculted for i2s frequency:%f Mhz N:%d B:%d A:%d\n",freq/1000000,CLOCK_DIVIDER_N,CLOCK_DIVIDER_B,CLOCK_DIVIDER_A);
-        // double pulseduration=1000000000/freq;
-        // printf("Pulse duration: %f ns\n",pulseduration);
-        // gPulsesPerBit = (T1ns + T2ns + T3ns)/FASTLED_I2S_NS_PER_PULSE;
-        
-        //print("Pulses per bit: "); println(gPulsesPerBit);
-        
-        //int ones_for_one  = ((T1ns + T2ns - 1)/FASTLED_I2S_NS_PER_PULSE) + 1;
-        ones_for_one  = T1/pgc_ +T2/pgc_;
-        //print("One bit:  target ");
-        //print(T1ns+T2ns); print("ns --- ");
-        //print(ones_for_one); print(" 1 bits");
-        //print(" = "); print(ones_for_one * FASTLED_I2S_NS_PER_PULSE); println("ns");
-        // printf("one bit : target %d  ns --- %d  pulses 1 bit = %f ns\n",T1ns+T2ns,ones_for_one ,ones_for_one*pulseduration);
-        
-        
-        int i = 0;
-        while ( i < ones_for_one ) {
-            gOneBit[i] = 0xFFFFFF00;
-            i++;
-        }
-        while ( i < gPulsesPerBit ) {
-            gOneBit[i] = 0x00000000;
-            i++;
-        }
-        
-        //int ones_for_zero = ((T1ns - 1)/FASTLED_I2S_NS_PER_PULSE) + 1;
-        ones_for_zero =T1/pgc_  ;
-       // print("Zero bit:  target ");
-       // print(T1ns); print("ns --- ");
-        //print(ones_for_zero); print(" 1 bits");
-        //print(" = "); print(ones_for_zero * FASTLED_I2S_NS_PER_PULSE); println("ns");
-        // printf("Zero bit : target %d ns --- %d pulses  1 bit =   %f ns\n",T1ns,ones_for_zero ,ones_for_zero*pulseduration);
-        i = 0;
-        while ( i < ones_for_zero ) {
-            gZeroBit[i] = 0xFFFFFF00;
-            i++;
-        }
-        while ( i < gPulsesPerBit ) {
-            gZeroBit[i] = 0x00000000;
-            i++;
-        }
-        
-        memset(gPixelRow, 0, NUM_COLOR_CHANNELS * 32);
-        memset(gPixelBits, 0, NUM_COLOR_CHANNELS * 32);
-    }
-    
-    static DMABuffer * allocateDMABuffer(int bytes)
-    {
-        DMABuffer * b = (DMABuffer *)heap_caps_malloc(sizeof(DMABuffer), MALLOC_CAP_DMA);
-        
-        b->buffer = (uint8_t *)heap_caps_malloc(bytes, MALLOC_CAP_DMA);
-        memset(b->buffer, 0, bytes);
-        
-        b->descriptor.length = bytes;
-        b->descriptor.size = bytes;
-        b->descriptor.owner = 1;
-        b->descriptor.sosf = 1;
-        b->descriptor.buf = b->buffer;
-        b->descriptor.offset = 0;
-        b->descriptor.empty = 0;
-        b->descriptor.eof = 1;
-        b->descriptor.qe.stqe_next = 0;
-        
-        return b;
+        
+        // -- RGBW chipsets send a fourth byte, white, for every pixel
+        gNumColorChannels = COLOR_CHANNELS;
+
+        memset(gPixelRow, 0, MAX_COLOR_CHANNELS * 32);
+        memset(gPixelBits, 0, sizeof(gPixelBits));
     }
     
     static void i2sInit()
@@ -446,75 +769,16 @@ protected:
         initBitPatterns();
         
         // -- Choose whether to use I2S device 0 or device 1
-        //    Set up the various device-specific parameters
         int interruptSource;
-        if (I2S_DEVICE == 0) {
-            i2s = &I2S0;
-            periph_module_enable(PERIPH_I2S0_MODULE);
-            interruptSource = ETS_I2S0_INTR_SOURCE;
-            i2s_base_pin_index = I2S0O_DATA_OUT0_IDX;
-        } else {
-            i2s = &I2S1;
-            periph_module_enable(PERIPH_I2S1_MODULE);
-            interruptSource = ETS_I2S1_INTR_SOURCE;
-            i2s_base_pin_index = I2S1O_DATA_OUT0_IDX;
-        }
-        
-        // -- Reset everything
-        i2sReset();
-        i2sReset_DMA();
-        i2sReset_FIFO();
-        
-        // -- Main configuration
-        i2s->conf.tx_msb_right = 1;
-        i2s->conf.tx_mono = 0;
-        i2s->conf.tx_short_sync = 0;
-        i2s->conf.tx_msb_shift = 0;
-        i2s->conf.tx_right_first = 1; // 0;//1;
-        i2s->conf.tx_slave_mod = 0;
-        
-        // -- Set parallel mode
-        i2s->conf2.val = 0;
-        i2s->conf2.lcd_en = 1;
-        i2s->conf2.lcd_tx_wrx2_en = 0; // 0 for 16 or 32 parallel output
-        i2s->conf2.lcd_tx_sdx2_en = 0; // HN
-        
-        // -- Set up the clock rate and sampling
-        i2s->sample_rate_conf.val = 0;
-        i2s->sample_rate_conf.tx_bits_mod = 32; // Number of parallel bits/pins
-        i2s->sample_rate_conf.tx_bck_div_num = 1;
-        i2s->clkm_conf.val = 0;
-        i2s->clkm_conf.clka_en = 0;
-        
-        // -- Data clock is computed as Base/(div_num + (div_b/div_a))
-        //    Base is 80Mhz, so 80/(10 + 0/1) = 8Mhz
-        //    One cycle is 125ns
-        i2s->clkm_conf.clkm_div_a = CLOCK_DIVIDER_A;
-        i2s->clkm_conf.clkm_div_b = CLOCK_DIVIDER_B;
-        i2s->clkm_conf.clkm_div_num = CLOCK_DIVIDER_N;
-        
-        i2s->fifo_conf.val = 0;
-        i2s->fifo_conf.tx_fifo_mod_force_en = 1;
-        i2s->fifo_conf.tx_fifo_mod = 3;  // 32-bit single channel data
-        i2s->fifo_conf.tx_data_num = 32; // fifo length
-        i2s->fifo_conf.dscr_en = 1;      // fifo will use dma
-        
-        i2s->conf1.val = 0;
-        i2s->conf1.tx_stop_en = 0;
-        i2s->conf1.tx_pcm_bypass = 1;
-        
-        i2s->conf_chan.val = 0;
-        i2s->conf_chan.tx_chan_mod = 1; // Mono mode, with tx_msb_right = 1, everything goes to right-channel
-        
-        i2s->timing.val = 0;
-        
-        // -- Allocate two DMA buffers
-        dmaBuffers[0] = allocateDMABuffer(32 * NUM_COLOR_CHANNELS * gPulsesPerBit);
-        dmaBuffers[1] = allocateDMABuffer(32 * NUM_COLOR_CHANNELS * gPulsesPerBit);
-        
-        // -- Arrange them as a circularly linked list
-        dmaBuffers[0]->descriptor.qe.stqe_next = &(dmaBuffers[1]->descriptor);
-        dmaBuffers[1]->descriptor.qe.stqe_next = &(dmaBuffers[0]->descriptor);
+        i2s = i2sEnable(I2S_DEVICE, interruptSource, i2s_base_pin_index);
+        
+        i2sConfigure(i2s, CLOCK_DIVIDER_N, CLOCK_DIVIDER_A, CLOCK_DIVIDER_B);
+        
+        // -- Allocate the DMA buffers
+        //    In full frame mode they are allocated when the frame size is known
+        if ( ! FASTLED_I2S_FULL_FRAME) {
+            allocateRing();
+        }
        
         // -- Allocate i2s interrupt
         SET_PERI_REG_BITS(I2S_INT_ENA_REG(I2S_DEVICE), I2S_OUT_EOF_INT_ENA_V, 1, I2S_OUT_EOF_INT_ENA_S);
@@ -531,24 +795,61 @@ protected:
             xSemaphoreGive(gTX_sem);
         }
         
-        // println("Init I2S");
         gInitialized = true;
     }
     
+    // -- Allocate the DMA buffers and arrange them as a circularly
+    //    linked list. If there is not enough DMA memory, none are kept
+    //    and startShow() tries again.
+    static bool allocateRing()
+    {
+        int bytes = FASTLED_I2S_PIXELS_PER_BUFFER * ROW_WORDS * sizeof(uint32_t);
+        for (int i = 0; i < NUM_DMA_BUFFERS; i++) {
+            dmaBuffers[i] = i2sAllocateDMABuffer(bytes);
+            if (dmaBuffers[i] == NULL) {
+                ESP_LOGE("FastLED", "I2S: no DMA memory for %d buffers of %d bytes, dropping the frame", NUM_DMA_BUFFERS, bytes);
+                while (i > 0) {
+                    i--;
+                    i2sFreeDMABuffer(dmaBuffers[i]);
+                    dmaBuffers[i] = NULL;
+                }
+                return false;
+            }
+        }
+        
+        for (int i = 0; i < NUM_DMA_BUFFERS; i++) {
+            DMABuffer * b = dmaBuffers[i];
+            DMABuffer * next = dmaBuffers[(i + 1) % NUM_DMA_BUFFERS];
+            b->descriptors[b->numDescriptors - 1].qe.stqe_next = & (next->descriptors[0]);
+        }
+        return true;
+    }
+    
+    // -- Give up on a frame there is no DMA memory for
+    //    Nothing is sent, and the next show() starts afresh.
+    static void dropFrame()
+    {
+        for (int i = 0; I2S_SNAPSHOT && i < gNumControllers; i++) {
+            static_cast<ClocklessController*>(gControllers[i])->mDirect = false;
+        }
+        gNumStarted = 0;
+        xSemaphoreGive(gTX_sem);
+    }
+    
     /** Clear DMA buffer
      *
      *  Yves' clever trick: initialize the bits that we know must be 0
      *  or 1 regardless of what bit they encode.
      */
-    static void empty( uint32_t *buf)
+    static void empty( uint32_t *buf, int rows)
     {
-        for(int i=0;i<8*NUM_COLOR_CHANNELS;i++)
+        for(int i=0;i<8*COLOR_CHANNELS*rows;i++)
         {
-            int offset=gPulsesPerBit*i;
-            for(int j=0;j<ones_for_zero;j++)
+            int offset=PULSES_PER_BIT*i;
+            for(int j=0;j<ONES_FOR_ZERO;j++)
                 buf[offset+j]=0xffffffff;
             
-            for(int j=ones_for_one;j<gPulsesPerBit;j++)
+            for(int j=ONES_FOR_ONE;j<PULSES_PER_BIT;j++)
                 buf[offset+j]=0;
         }
     }
@@ -557,53 +858,218 @@ protected:
     //    This is the main entry point for the controller.
     virtual void showPixels(PixelController<RGB_ORDER> & pixels)
     {
-        if (gNumStarted == 0) {
-            // -- First controller: make sure everything is set up
-            xSemaphoreTake(gTX_sem, portMAX_DELAY);
+        if (I2S_SNAPSHOT) {
+            // -- Copy the pixels out while the previous frame is sent
+            snapshot(pixels);
+        } else {
+            if (gNumStarted == 0) {
+                // -- First controller: make sure everything is set up
+                xSemaphoreTake(gTX_sem, portMAX_DELAY);
+            }
+            
+            // -- Initialize the local state, save a pointer to the pixel
+            //    data. We need to make a copy because pixels is a local
+            //    variable in the calling function, and this data structure
+            //    needs to outlive this call to showPixels.
+            (*mPixels) = pixels;
         }
         
-        // -- Initialize the local state, save a pointer to the pixel
-        //    data. We need to make a copy because pixels is a local
-        //    variable in the calling function, and this data structure
-        //    needs to outlive this call to showPixels.
-        (*mPixels) = pixels;
-        
         // -- Keep track of the number of strips we've seen
         gNumStarted++;
 
-        // print("Show pixels ");
-        // println(gNumStarted);
+        // -- Outside of a flush, the last call to showPixels is the one
+        //    responsible for doing all of the actual work
+        if ( ! gFlushPending && gNumStarted == gNumControllers) {
+            startShow( ! I2S_SNAPSHOT);
+        }
+    }
+
+    // -- Scale and dither the pixels into the back snapshot
+    void snapshot(PixelController<RGB_ORDER> & pixels)
+    {
+        int bytes = pixels.size() * COLOR_CHANNELS;
+        if (bytes > mSnapshotBytes[mBack]) {
+            free(mSnapshot[mBack]);
+            mSnapshot[mBack] = (uint8_t *) malloc(bytes);
+            mSnapshotBytes[mBack] = mSnapshot[mBack] ? bytes : 0;
+            if (mSnapshot[mBack] == NULL) {
+                ESP_LOGE("FastLED", "I2S: no memory for a %d byte snapshot, showing synchronously", bytes);
+                (*mPixels) = pixels;
+                mDirect = true;
+                return;
+            }
+        }
         
-        // -- The last call to showPixels is the one responsible for doing
-        //    all of the actual work
-        if (gNumStarted == gNumControllers) {
-            empty((uint32_t*)dmaBuffers[0]->buffer);
-            empty((uint32_t*)dmaBuffers[1]->buffer);
-            gCurBuffer = 0;
-            gDoneFilling = false;
-            
-            // -- Prefill both buffers
-            fillBuffer();
+        uint8_t * px = mSnapshot[mBack];
+        while (pixels.has(1)) {
+            if (WHITE != RGBW_NONE) {
+                px[3] = pixels.template loadAndScaleRGBW<WHITE>(px[0], px[1], px[2]);
+            } else {
+                px[0] = pixels.loadAndScale0();
+                px[1] = pixels.loadAndScale1();
+                px[2] = pixels.loadAndScale2();
+            }
+            pixels.advanceData();
+            pixels.stepDithering();
+            px += COLOR_CHANNELS;
+        }
+        
+        mSnapshotLen[mBack] = bytes;
+        mShown = true;
+    }
+    
+    // -- Send all of the controllers that have been shown
+    //    Strips that were not shown have no data left, so they are
+    //    masked out of the signal. If wait is set, return once they
+    //    have been sent.
+    static void startShow(bool wait)
+    {
+        if (FASTLED_I2S_FULL_FRAME) {
+            startFrame();
+            gNumStarted = 0;
+            return;
+        }
+        
+        if (I2S_SNAPSHOT) {
+            // -- Wait for the previous frame, then send the snapshots
+            //    that were just taken. Strips that were not shown send
+            //    nothing; one that had no memory for its snapshot is sent
+            //    from its pixels, and this waits until it has been.
+            i2sWaitForShowDone();
+            i2sStop();
+            for (int i = 0; i < gNumControllers; i++) {
+                ClocklessController * pController = static_cast<ClocklessController*>(gControllers[i]);
+                if (pController->mDirect) {
+                    pController->mSnapPos = pController->mSnapEnd;
+                    wait = true;
+                } else if (pController->mShown) {
+                    int front = pController->mBack;
+                    pController->mBack = 1 - front;
+                    pController->mSnapPos = 0;
+                    pController->mSnapEnd = pController->mSnapshotLen[front];
+                    pController->mShown = false;
+                } else {
+                    pController->mSnapPos = pController->mSnapEnd;
+                }
+            }
+            xSemaphoreTake(gTX_sem, portMAX_DELAY);
+        }
+        
+        if (dmaBuffers[0] == NULL && ! allocateRing()) {
+            dropFrame();
+            return;
+        }
+        
+        for (int i = 0; i < NUM_DMA_BUFFERS; i++) {
+            empty((uint32_t*)dmaBuffers[i]->buffer, FASTLED_I2S_PIXELS_PER_BUFFER);
+            for (int row = 0; row < FASTLED_I2S_PIXELS_PER_BUFFER; row++) {
+                gBufferMask[i][row] = 0xFFFFFFFF;
+            }
+        }
+        gCurBuffer = 0;
+        gDoneFilling = false;
+        gDataBuffers = 0;
+        gBuffersSent = 0;
+        
+        // -- Prefill all of the buffers
+        for (int i = 0; i < NUM_DMA_BUFFERS; i++) {
             fillBuffer();
-            
-            // -- Make sure it's been at least 50ms since last show
-            mWait.wait();
+        }
+        
+        // -- Make sure it's been at least 50ms since last show
+        gWait.wait();
 
-            i2sStart();
-            
-            // -- Wait here while the rest of the data is sent. The interrupt handler
-            //    will keep refilling the DMA buffers until it is all sent; then it
-            //    gives the semaphore back.
+        i2sStart(dmaBuffers[0]);
+        
+        // -- Reset the counters
+        gShowPending = true;
+        gNumStarted = 0;
+        
+        // -- Wait here while the rest of the data is sent. The interrupt handler
+        //    will keep refilling the DMA buffers until it is all sent; then it
+        //    gives the semaphore back.
+        if (wait) {
+            i2sWaitForShowDone();
+            i2sStop();
+        }
+        
+        for (int i = 0; I2S_SNAPSHOT && i < gNumControllers; i++) {
+            static_cast<ClocklessController*>(gControllers[i])->mDirect = false;
+        }
+    }
+    
+    // -- Encode the whole frame and start sending it
+    //    The semaphore was taken by the first showPixels(), once the
+    //    previous frame was done (or, when looping, done with a pass).
+    static void startFrame()
+    {
+        // -- A looping frame is stopped at the end of a pass, while the
+        //    next pass is still sending its latch rows
+        if (gFrameRunning && FASTLED_I2S_FULL_FRAME_LOOP) {
+            xSemaphoreTake(gTX_sem, 0);
             xSemaphoreTake(gTX_sem, portMAX_DELAY);
-            xSemaphoreGive(gTX_sem);
-            
+        }
+        if (gFrameRunning) {
             i2sStop();
-            
-            mWait.mark();
-
-            // -- Reset the counters
-            gNumStarted = 0;
+            gFrameRunning = false;
+        }
+        
+        // -- Rows: the latch, then the longest strip, then one low row
+        //    so the line is left low when the DMA stops
+        int row_words = ROW_WORDS;
+        uint32_t row_ns = 8 * COLOR_CHANNELS * gNsPerBit;
+        int latch_rows = (300000 + row_ns - 1) / row_ns;
+        int data_rows = 0;
+        for (int i = 0; i < gNumControllers; i++) {
+            ClocklessController * pController = static_cast<ClocklessController*>(gControllers[i]);
+            if (pController->mPixels->mLenRemaining > data_rows) {
+                data_rows = pController->mPixels->mLenRemaining;
+            }
+        }
+        int rows = latch_rows + data_rows + 1;
+        
+        // -- Grow the frame if needed
+        if (rows > gFrameRows) {
+            i2sFreeDMABuffer(gFrame);
+            gFrame = i2sAllocateDMABuffer(rows * row_words * sizeof(uint32_t));
+            gFrameRows = gFrame ? rows : 0;
+            if (gFrame == NULL) {
+                ESP_LOGE("FastLED", "I2S: no DMA memory for a %d row frame, dropping it", rows);
+                dropFrame();
+                return;
+            }
+        }
+        
+        // -- Encode
+        uint32_t * buf = (uint32_t *) gFrame->buffer;
+        memset(buf, 0, latch_rows * row_words * sizeof(uint32_t));
+        buf += latch_rows * row_words;
+        empty(buf, data_rows);
+        for (int row = 0; row < data_rows; row++) {
+            uint32_t mask = 0xFFFFFFFF;
+            fillRow(buf, mask);
+            buf += row_words;
         }
+        memset(buf, 0, (gFrameRows - latch_rows - data_rows) * row_words * sizeof(uint32_t));
+        
+        // -- Send only the rows we need, once or round and round
+        int bytes = rows * row_words * sizeof(uint32_t);
+        for (int i = 0; i < gFrame->numDescriptors; i++) {
+            lldesc_t * d = & gFrame->descriptors[i];
+            int offset = i * DMA_MAX_DESCRIPTOR_BYTES;
+            bool last = (offset + DMA_MAX_DESCRIPTOR_BYTES >= bytes);
+            d->length = last ? (bytes - offset) : DMA_MAX_DESCRIPTOR_BYTES;
+            d->size = d->length;
+            d->eof = last ? 1 : 0;
+            if (last) {
+                d->qe.stqe_next = FASTLED_I2S_FULL_FRAME_LOOP ? & gFrame->descriptors[0] : 0;
+                break;
+            }
+            d->qe.stqe_next = & gFrame->descriptors[i+1];
+        }
+        
+        i2sStart(gFrame);
+        gFrameRunning = true;
     }
     
     // -- Custom interrupt handler
@@ -612,9 +1078,34 @@ protected:
         if (i2s->int_st.out_eof) {
             i2s->int_clr.val = i2s->int_raw.val;
             
-            if ( ! gDoneFilling) {
-                fillBuffer();
-            } else {
+            // -- A full frame is sent by the hardware alone: this is
+            //    the end of it, or of one pass around the loop
+            if (FASTLED_I2S_FULL_FRAME) {
+                portBASE_TYPE HPTaskAwoken = 0;
+                xSemaphoreGiveFromISR(gTX_sem, &HPTaskAwoken);
+                if(HPTaskAwoken == pdTRUE) portYIELD_FROM_ISR();
+                return;
+            }
+            
+            // -- The buffer that was just sent is refilled; after the
+            //    last pixel, with silence, in case the DMA gets back to
+            //    it before we stop
+            gBuffersSent++;
+            fillBuffer();
+            
+            // -- Without I2S_OUT_EOF_MODE, out_eof only means the DMA
+            //    has read the buffer into the FIFO, and the end of it
+            //    is still to be sent. So wait for the EOF of the silent
+            //    buffer after the last one with pixels: stopping then
+            //    only cuts off silence.
+            if (gDoneFilling && gBuffersSent > gDataBuffers) {
+                // -- Stop here rather than in the task, which may be busy
+                //    rendering the next frame
+                i2s->int_ena.out_eof = 0;
+                i2s->conf.tx_start = 0;
+                
+                if (gShowDoneFn) gShowDoneFn(gShowDoneArg);
+                
                 portBASE_TYPE HPTaskAwoken = 0;
                 xSemaphoreGiveFromISR(gTX_sem, &HPTaskAwoken);
                 if(HPTaskAwoken == pdTRUE) portYIELD_FROM_ISR();
@@ -624,29 +1115,66 @@ protected:
     
     /** Fill DMA buffer
      *
-     *  This is where the real work happens: take a row of pixels (one
-     *  from each strip), transpose and encode the bits, and store
-     *  them in the DMA buffer for the I2S peripheral to read.
+     *  Fill the next buffer in the ring with FASTLED_I2S_PIXELS_PER_BUFFER
+     *  pixel rows. Rows past the end of the data are silent.
      */
     static IRAM_ATTR void fillBuffer()
     {
-        // -- Alternate between buffers
-        volatile uint32_t * buf = (uint32_t *) dmaBuffers[gCurBuffer]->buffer;
+        // -- Step around the ring of buffers
+        int cur = gCurBuffer;
+        volatile uint32_t * buf = (uint32_t *) dmaBuffers[cur]->buffer;
         gCurBuffer = (gCurBuffer + 1) % NUM_DMA_BUFFERS;
         
+        bool has_data = false;
+        for (int row = 0; row < FASTLED_I2S_PIXELS_PER_BUFFER; row++) {
+            volatile uint32_t * row_buf = buf + row * ROW_WORDS;
+            if (fillRow(row_buf, gBufferMask[cur][row])) has_data = true;
+        }
+        
+        // -- Count the buffers that carry pixels, so the interrupt
+        //    handler knows when the last of them has been sent
+        if (has_data) {
+            gDataBuffers++;
+        } else {
+            gDoneFilling = true;
+        }
+    }
+    
+    /** Fill one pixel row
+     *
+     *  This is where the real work happens: take a row of pixels (one
+     *  from each strip), transpose and encode the bits, and store
+     *  them in the DMA buffer for the I2S peripheral to read.
+     *  Returns false if none of the strips had a pixel left.
+     */
+    static IRAM_ATTR bool fillRow(volatile uint32_t * buf, uint32_t & buf_mask)
+    {
         // -- Get the requested pixel from each controller. Store the
         //    data for each color channel in a separate array.
         uint32_t has_data_mask = 0;
         for (int i = 0; i < gNumControllers; i++) {
-            // -- Store the pixels in reverse controller order starting at index 23
-            //    This causes the bits to come out in the right position after we
-            //    transpose them.
-            int bit_index = 23-i;
+            // -- Store the pixels in controller order; after the
+            //    transpose, strip i is bit i+8 of each word
+            int bit_index = i;
             ClocklessController * pController = static_cast<ClocklessController*>(gControllers[i]);
-            if (pController->mPixels->has(1)) {
-                gPixelRow[0][bit_index] = pController->mPixels->loadAndScale0();
-                gPixelRow[1][bit_index] = pController->mPixels->loadAndScale1();
-                gPixelRow[2][bit_index] = pController->mPixels->loadAndScale2();
+            if (I2S_SNAPSHOT && ! pController->mDirect) {
+                if (pController->mSnapPos < pController->mSnapEnd) {
+                    const uint8_t * px = pController->mSnapshot[1 - pController->mBack] + pController->mSnapPos;
+                    for (int channel = 0; channel < COLOR_CHANNELS; channel++) {
+                        gPixelRow[channel][bit_index] = px[channel];
+                    }
+                    pController->mSnapPos += COLOR_CHANNELS;
+                    has_data_mask |= (1 << (i+8));
+                }
+            } else if (pController->mPixels->has(1)) {
+                if (WHITE != RGBW_NONE) {
+                    gPixelRow[3][bit_index] = pController->mPixels->template loadAndScaleRGBW<WHITE>(
+                        gPixelRow[0][bit_index], gPixelRow[1][bit_index], gPixelRow[2][bit_index]);
+                } else {
+                    gPixelRow[0][bit_index] = pController->mPixels->loadAndScale0();
+                    gPixelRow[1][bit_index] = pController->mPixels->loadAndScale1();
+                    gPixelRow[2][bit_index] = pController->mPixels->loadAndScale2();
+                }
                 pController->mPixels->advanceData();
                 pController->mPixels->stepDithering();
                 
@@ -655,89 +1183,64 @@ protected:
             }
         }
         
-        // -- None of the strips has data? We are done.
-        if (has_data_mask == 0) {
-            gDoneFilling = true;
-            return;
+        // -- The leading pulses of every bit are high for all strips
+        //    (see empty()). When the set of strips with data changes,
+        //    turn them off for the ones that are done or not shown.
+        if (has_data_mask != buf_mask) {
+            for (int i = 0; i < 8 * COLOR_CHANNELS; i++) {
+                for (int pulse_num = 0; pulse_num < ONES_FOR_ZERO; pulse_num++) {
+                    buf[i*PULSES_PER_BIT+pulse_num] = has_data_mask;
+                }
+            }
+            buf_mask = has_data_mask;
         }
         
+        // -- None of the strips has data? Then the row is silent.
+        if (has_data_mask == 0) {
+            for (int i = 0; i < 8 * COLOR_CHANNELS; i++) {
+                for (int pulse_num = ONES_FOR_ZERO; pulse_num < ONES_FOR_ONE; pulse_num++) {
+                    buf[i*PULSES_PER_BIT+pulse_num] = 0;
+                }
+            }
+            return false;
+        }
+
         // -- Transpose and encode the pixel data for the DMA buffer
         // int buf_index = 0;
-        for (int channel = 0; channel < NUM_COLOR_CHANNELS; channel++) {
+        for (int channel = 0; channel < COLOR_CHANNELS; channel++) {
             
             // -- Tranpose each array: all the bit 7's, then all the bit 6's, ...
-            transpose32(gPixelRow[channel], gPixelBits[channel][0] );
+            transpose24(gPixelRow[channel], gPixelBits);
             
-            //print("Channel: "); print(channel); print(" ");
             for (int bitnum = 0; bitnum < 8; bitnum++) {
-                uint8_t * row = (uint8_t *) (gPixelBits[channel][bitnum]);
-                uint32_t bit = (row[0] << 24) | (row[1] << 16) | (row[2] << 8) | row[3];
+                uint32_t bit = gPixelBits[bitnum];
                 
-               /* SZG: More general, but too slow:
-                    for (int pulse_num = 0; pulse_num < gPulsesPerBit; pulse_num++) {
-                        buf[buf_index++] = has_data_mask & ( (bit & gOneBit[pulse_num]) | (~bit & gZeroBit[pulse_num]) );
-                     }
-               */
-
                 // -- Only fill in the pulses that are different between the "0" and "1" encodings
-                for(int pulse_num = ones_for_zero; pulse_num < ones_for_one; pulse_num++) {
-                    buf[bitnum*gPulsesPerBit+channel*8*gPulsesPerBit+pulse_num] = has_data_mask & bit;
+                //    The bounds are constants, so the compiler unrolls this
+                volatile uint32_t * pulses = buf + (channel*8 + bitnum)*PULSES_PER_BIT;
+                uint32_t val = has_data_mask & bit;
+                for(int pulse_num = ONES_FOR_ZERO; pulse_num < ONES_FOR_ONE; pulse_num++) {
+                    pulses[pulse_num] = val;
                 }
             }
         }
-    }
-    
-    static void transpose32(uint8_t * pixels, uint8_t * bits)
-    {
-        transpose8rS32(& pixels[0],  1, 4, & bits[0]);
-        transpose8rS32(& pixels[8],  1, 4, & bits[1]);
-        transpose8rS32(& pixels[16], 1, 4, & bits[2]);
-        //transpose8rS32(& pixels[24], 1, 4, & bits[3]);  Can only use 24 bits
-    }
-    
-    /** Transpose 8x8 bit matrix
-     *  From Hacker's Delight
-     */
-    static void transpose8rS32(uint8_t * A, int m, int n, uint8_t * B)
-    {
-        uint32_t x, y, t;
-        
-        // Load the array and pack it into x and y.
-        
-        x = (A[0]<<24)   | (A[m]<<16)   | (A[2*m]<<8) | A[3*m];
-        y = (A[4*m]<<24) | (A[5*m]<<16) | (A[6*m]<<8) | A[7*m];
         
-        t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
-        t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
-        
-        t = (x ^ (x >>14)) & 0x0000CCCC;  x = x ^ t ^ (t <<14);
-        t = (y ^ (y >>14)) & 0x0000CCCC;  y = y ^ t ^ (t <<14);
-        
-        t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
-        y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
-        x = t;
-        
-        B[0]=x>>24;    B[n]=x>>16;    B[2*n]=x>>8;  B[3*n]=x;
-        B[4*n]=y>>24;  B[5*n]=y>>16;  B[6*n]=y>>8;  B[7*n]=y;
+        return true;
     }
     
     /** Start I2S transmission
      */
-    static void i2sStart()
+    static void i2sStart(DMABuffer * first)
     {
         // esp_intr_disable(gI2S_intr_handle);
-        // println("I2S start");
-        i2sReset();
-        //println(dmaBuffers[0]->sampleCount());
+        i2sReset(i2s);
         i2s->lc_conf.val=I2S_OUT_DATA_BURST_EN | I2S_OUTDSCR_BURST_EN | I2S_OUT_DATA_BURST_EN;
-        i2s->out_link.addr = (uint32_t) & (dmaBuffers[0]->descriptor);
+        i2s->out_link.addr = (uint32_t)(uintptr_t) & (first->descriptors[0]);
         i2s->out_link.start = 1;
-        ////vTaskDelay(5);
         i2s->int_clr.val = i2s->int_raw.val;
         // //vTaskDelay(5);
         i2s->int_ena.out_dscr_err = 1;
         //enable interrupt
-        ////vTaskDelay(5);
         esp_intr_enable(gI2S_intr_handle);
         // //vTaskDelay(5);
         i2s->int_ena.val = 0;
@@ -747,35 +1250,10 @@ protected:
         i2s->conf.tx_start = 1;
     }
     
-    static void i2sReset()
-    {
-        // println("I2S reset");
-        const unsigned long lc_conf_reset_flags = I2S_IN_RST_M | I2S_OUT_RST_M | I2S_AHBM_RST_M | I2S_AHBM_FIFO_RST_M;
-        i2s->lc_conf.val |= lc_conf_reset_flags;
-        i2s->lc_conf.val &= ~lc_conf_reset_flags;
-        
-        const uint32_t conf_reset_flags = I2S_RX_RESET_M | I2S_RX_FIFO_RESET_M | I2S_TX_RESET_M | I2S_TX_FIFO_RESET_M;
-        i2s->conf.val |= conf_reset_flags;
-        i2s->conf.val &= ~conf_reset_flags;
-    }
-    
-    static void i2sReset_DMA()
-    {
-        i2s->lc_conf.in_rst=1; i2s->lc_conf.in_rst=0;
-        i2s->lc_conf.out_rst=1; i2s->lc_conf.out_rst=0;
-    }
-    
-    static void i2sReset_FIFO()
-    {
-        i2s->conf.rx_fifo_reset=1; i2s->conf.rx_fifo_reset=0;
-        i2s->conf.tx_fifo_reset=1; i2s->conf.tx_fifo_reset=0;
-    }
-    
     static void i2sStop()
     {
-        // println("I2S stop");
         esp_intr_disable(gI2S_intr_handle);
-        i2sReset();
+        i2sReset(i2s);
         i2s->conf.rx_start = 0;
         i2s->conf.tx_start = 0;
     }
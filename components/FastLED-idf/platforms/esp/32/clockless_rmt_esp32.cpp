@@ -19,115 +19,57 @@ static ESP32RMTController * gControllers[FASTLED_RMT_MAX_CONTROLLERS];
 //    channel assigned to them.
 static ESP32RMTController * gOnChannel[FASTLED_RMT_MAX_CHANNELS];
 
+// -- Controllers in the current frame, in the order they were shown
+static ESP32RMTController * gShowing[FASTLED_RMT_MAX_CONTROLLERS];
+
+// -- The RMT channel and number of memory blocks behind each of our
+//    channels, and the memory blocks each RMT channel is set up with
+static rmt_channel_t gChannelRMT[FASTLED_RMT_MAX_CHANNELS];
+static int gChannelBlocks[FASTLED_RMT_MAX_CHANNELS];
+static int gNumChannels = 0;
+static int gRMTBlocks[8];
+
+// -- Worst refill latency seen so far, in CPU cycles past the
+//    expected refill time
+static uint32_t gMaxLateCycles = 0;
+
 static int gNumControllers = 0;
 static int gNumStarted = 0;
+static int gNumShowing = 0;
 static int gNumDone = 0;
 static int gNext = 0;
 
+// -- Inside a beginFlush()/flush() pair: hold the frame until flush()
+static bool gFlushPending = false;
+
 static intr_handle_t gRMT_intr_handle = NULL;
 
 // -- Global semaphore for the whole show process
 //    Semaphore is not given until all data has been sent
 static xSemaphoreHandle gTX_sem = NULL;
 
+// -- Asynchronous show: a frame was started but nobody has waited for it yet
+static bool gShowPending = false;
+
+// -- Optional notification when a frame is done
+static rmt_show_done_fn gShowDoneFn = NULL;
+static void * gShowDoneArg = NULL;
+
 // -- Make sure we can't call show() too quickly (fastled library)
 CMinWait<55>   gWait;
 
 static bool gInitialized = false;
 
-/*
-** general DRAM system for printing during faster IRQs
-** be careful not to set the size too large, because code that prints
-** has the tendancy to do a stack alloc of the same size...
-*/
-
-// -- BB: For debugging purposes
-#if FASTLED_ESP32_SHOWTIMING == 1
-
-#define MEMORYBUF_SIZE 256
-DRAM_ATTR char g_memorybuf[MEMORYBUF_SIZE] = {0};
-DRAM_ATTR char *g_memorybuf_write = g_memorybuf;
-
-void IRAM_ATTR memorybuf_add( char *b ) {
-
-    int buflen = strlen(b);
-
-    // don't overflow
-    int bufRemain = sizeof(g_memorybuf) - ( g_memorybuf_write - g_memorybuf );
-    if ( bufRemain == 0 ) return;
-    if (bufRemain < buflen) buflen = bufRemain;
-
-    memcpy(g_memorybuf_write, b, buflen);
-    g_memorybuf_write += buflen;
-}
-
-void IRAM_ATTR memorybuf_add( char c ) {
-
-    // don't overflow
-    int bufRemain = sizeof(g_memorybuf) - ( g_memorybuf_write - g_memorybuf );
-    if ( bufRemain < 1 ) return;
-
-    *g_memorybuf_write = c;
-    g_memorybuf_write++;
-}
-
-void IRAM_ATTR memorybuf_insert( char *b, int buflen ) {
-    // don't overflow
-    int maxbuf = sizeof(g_memorybuf) - ( g_memorybuf_write - g_memorybuf );
-    if ( maxbuf == 0 ) return;
-    if (maxbuf < buflen) buflen = maxbuf;
-
-    memcpy(g_memorybuf_write, b, buflen);
-    g_memorybuf_write += buflen;
-}
-
-// often one wants a separator and an integer, do a helper
-void IRAM_ATTR memorybuf_int( int i, char sep) {
-
-    // am I full already?
-    int maxbuf = sizeof(g_memorybuf) - ( g_memorybuf_write - g_memorybuf );
-    if ( maxbuf == 0 ) return;
-
-    // for speed, just make sure I have 12 bytes, even though maybe I need fewer
-    // 12 is the number because I need a null which I will fill with sep, and 
-    // there's always the chance of a minus
-    if (maxbuf <= 12) return;
-
-    // prep the buf and find the length ( can't copy)
-    itoa(i, g_memorybuf_write, 10);
-    int buflen = strlen(g_memorybuf_write);
-    g_memorybuf_write[buflen] = sep;
-    g_memorybuf_write += (buflen + 1);
-
-}
-
-// get from the front... requires a memmove because overlaps.
-// *len input is the size of the buf, return is the length you got
-
-// this will always be the most efficient if you ask for a buffer that's as large as the
-// capture buffer
-void memorybuf_get(char *b, int *len) {
-    // amount in the buffer
-    int blen = g_memorybuf_write - g_memorybuf ;
-    if ( blen == 0 ) {
-        *len = 0;
-        return;
-    }
-    if (blen > *len) {
-        memcpy(b, g_memorybuf, *len);
-        int olen = blen - *len;
-        memmove(g_memorybuf, g_memorybuf_write - olen, olen);
-        g_memorybuf_write = g_memorybuf + olen;
-    }
-    else {
-        memcpy(b, g_memorybuf, blen);
-        g_memorybuf_write = g_memorybuf;
-        *len = blen;
-    }
-    return;
-}
-
-#endif /* FASTLED_ESP32_SHOWTIMING == 1 */
+// -- Timing statistics
+//    Updated by the interrupt handler; times are kept in CPU cycles
+//    and converted when they are read.
+static ESP32RMTStats gStats;
+static uint32_t gChannelMaxLateCycles[FASTLED_RMT_MAX_CHANNELS];
+static uint32_t gMaxIsrCycles = 0;
+static uint32_t gFrameStartCycles = 0;
+static uint32_t gFrameBytes = 0;
+static bool     gFrameAborted = false;
+static bool     gFrameLost = false;
 
 
 
@@ -204,9 +146,15 @@ static inline void fastled_set_mem_owner(rmt_channel_t channel, uint8_t owner)
 
 
 ESP32RMTController::ESP32RMTController(int DATA_PIN, int T1, int T2, int T3)
-    : mPixelData(0), 
+    : mByteItems(0),
+      mPixelData(0), 
+      mDataSize(0),
       mSize(0), 
       mCur(0), 
+      mStripValid(false),
+      mRetries(0),
+      mAborted(false),
+      mLatching(false),
       mWhichHalf(0),
       mBuffer(0),
       mBufferSize(0),
@@ -228,11 +176,18 @@ ESP32RMTController::ESP32RMTController(int DATA_PIN, int T1, int T2, int T3)
     mZero.level1 = 0;
     mZero.duration1 = ESP_TO_RMT_CYCLES(T2+T3); // TO_RMT_CYCLES(T2 + T3);
 
+    if (FASTLED_RMT_BYTE_LUT) {
+        initByteItems();
+    }
+
     gControllers[gNumControllers] = this;
     gNumControllers++;
 
     // -- Expected number of CPU cycles between buffer fills
-    mCyclesPerFill = (T1 + T2 + T3) * PULSES_PER_FILL;
+    //    (recomputed when the controller is given a channel)
+    mCyclesPerBit = T1 + T2 + T3;
+    mPulsesPerFill = PULSES_PER_FILL;
+    mCyclesPerFill = mCyclesPerBit * mPulsesPerFill;
 
     // -- If there is ever an interval greater than 1.75 times
     //    the expected time, then bail out.
@@ -241,18 +196,60 @@ ESP32RMTController::ESP32RMTController(int DATA_PIN, int T1, int T2, int T3)
     mPin = gpio_num_t(DATA_PIN);
 }
 
+// -- Build the byte lookup table
+//    Each byte value maps to the 8 RMT items that encode it, MSB
+//    first. The table only depends on the one and zero items, so
+//    controllers with the same timing share it.
+void ESP32RMTController::initByteItems()
+{
+    for (int i = 0; i < gNumControllers; i++) {
+        ESP32RMTController * pOther = gControllers[i];
+        if (pOther->mByteItems &&
+            pOther->mOne.val == mOne.val && pOther->mZero.val == mZero.val) {
+            mByteItems = pOther->mByteItems;
+            return;
+        }
+    }
+
+    // -- Read from the interrupt handler, so it must not end up in PSRAM
+    mByteItems = (uint32_t *) heap_caps_malloc(256 * 8 * sizeof(uint32_t), MALLOC_CAP_INTERNAL | MALLOC_CAP_32BIT);
+    if (mByteItems == 0) return;
+
+    uint32_t * pItem = mByteItems;
+    for (uint32_t byteval = 0; byteval < 256; byteval++) {
+        for (int bit = 7; bit >= 0; bit--) {
+            *pItem++ = (byteval & (1 << bit)) ? mOne.val : mZero.val;
+        }
+    }
+}
+
 // -- Get or create the buffer for the pixel data
 //    We can't allocate it ahead of time because we don't have
 //    the PixelController object until show is called.
 uint32_t * ESP32RMTController::getPixelBuffer(int size_in_bytes)
 {
     if (mPixelData == 0) {
-        mSize = ((size_in_bytes-1) / sizeof(uint32_t)) + 1;
-        mPixelData = (uint32_t *) calloc( mSize, sizeof(uint32_t));
+        mDataSize = ((size_in_bytes-1) / sizeof(uint32_t)) + 1;
+        mPixelData = (uint32_t *) calloc( mDataSize, sizeof(uint32_t));
     }
+    mSize = mDataSize;
     return mPixelData;
 }
 
+// -- Only send the first words of the pixel buffer
+void ESP32RMTController::setDirtyWords(int words)
+{
+    // -- We don't know what the strip shows until it has had a full frame
+    if ( ! mStripValid) {
+        mStripValid = true;
+        return;
+    }
+
+    // -- 3 words is 4 RGB (or 3 RGBW) pixels: round up so we stop on a pixel boundary
+    words = ((words + 2) / 3) * 3;
+    if (words < mSize) mSize = words;
+}
+
 // -- Initialize RMT subsystem
 //    This only needs to be done once
 void ESP32RMTController::init()
@@ -271,6 +268,9 @@ void ESP32RMTController::init()
 
         // if you are using MEM_BLOCK_NUM, the RMT channel won't be the same as the "channel number"
         rmt_channel_t rmt_channel = rmt_channel_t(i * MEM_BLOCK_NUM);
+        gChannelRMT[i] = rmt_channel;
+        gChannelBlocks[i] = MEM_BLOCK_NUM;
+        gRMTBlocks[rmt_channel] = MEM_BLOCK_NUM;
 
         // -- RMT configuration for transmission
         // NOTE: In ESP-IDF 4.1++, there is a #define to init, but that doesn't exist
@@ -313,6 +313,8 @@ void ESP32RMTController::init()
         }
     }
 
+    gNumChannels = FASTLED_RMT_MAX_CHANNELS;
+
     if ( ! FASTLED_RMT_BUILTIN_DRIVER ) {
         // -- Allocate the interrupt if we have not done so yet. This
         //    interrupt handler must work for all different kinds of
@@ -344,64 +346,235 @@ void ESP32RMTController::showPixels()
 #endif
     }
 
-    // -- Keep track of the number of strips we've seen
-    gNumStarted++;
+    // -- Keep track of the strips we've seen
+    //    A controller shown twice in one frame (e.g. listed twice in a
+    //    flushLeds() call) is only sent once, with its latest data; two
+    //    channels must never share its buffer and position.
+    bool queued = false;
+    for (int i = 0; i < gNumStarted; i++) {
+        if (gShowing[i] == this) {
+            queued = true;
+            break;
+        }
+    }
+    if ( ! queued && gNumStarted < FASTLED_RMT_MAX_CONTROLLERS) {
+        gShowing[gNumStarted] = this;
+        gNumStarted++;
+    }
+    mRetries = 0;
+
+    // -- Outside of a flush, the last call to showPixels is the one
+    //    responsible for doing all of the actual work
+    if ( ! gFlushPending && gNumStarted == gNumControllers) {
+        startShow( ! FASTLED_RMT_ASYNC_SHOW);
+    }
+}
+
+// -- Start a batch of output
+//    Controllers shown from now on are held until flush()
+void ESP32RMTController::beginFlush()
+{
+    gFlushPending = true;
+}
+
+// -- Send the controllers shown since beginFlush()
+//    Called once for every controller in the batch, so only the
+//    first call does anything.
+void ESP32RMTController::flush()
+{
+    gFlushPending = false;
+    if (gNumStarted > 0) {
+        startShow(false);
+    }
+}
+
+// -- Wait for the controllers sent by flush()
+void ESP32RMTController::waitFlush()
+{
+    if ( ! FASTLED_RMT_ASYNC_SHOW) {
+        waitForShowDone();
+    }
+}
+
+// -- Send all of the controllers that have been shown
+void ESP32RMTController::startShow(bool wait)
+{
+    gNumShowing = gNumStarted;
+    gNext = 0;
+    gNumDone = 0;
+
+    planChannels();
+
+    gFrameBytes = 0;
+    for (int i = 0; i < gNumShowing; i++) {
+        gFrameBytes += gShowing[i]->mSize * sizeof(uint32_t);
+    }
+    gFrameAborted = false;
+    gFrameLost = false;
+
+    // -- This Take always succeeds immediately
+    xSemaphoreTake(gTX_sem, portMAX_DELAY);
+
+    // -- Make sure it's been at least 50us since last show
+    // this is very conservative if you have multiple channels,
+    // arguably there should be a wait on the startnext of each LED string
+    gWait.wait();
+
+    gFrameStartCycles = __clock_cycles();
+
+    // -- First, fill all the available channels and start them
+    int channel = 0;
+    while ( (channel < gNumChannels) && (gNext < gNumShowing) ) {
+
+        ESP32RMTController::startNext(channel);
+
+        channel++;
+    }
+
+    gNumStarted = 0;
+    gShowPending = true;
+
+    // -- Asynchronous: the pixel data has already been copied, so
+    //    let the caller get on with the next frame. The next show
+    //    (or an explicit waitForShowDone) finishes up.
+    if ( ! wait) return;
 
-    // -- The last call to showPixels is the one responsible for doing
-    //    all of the actual work
-    if (gNumStarted == gNumControllers) {
-        gNext = 0;
+    // -- Wait here while the data is sent. The interrupt handler
+    //    will keep refilling the RMT buffers until it is all
+    //    done; then it gives the semaphore back.
+    waitForShowDone();
+}
 
-        // -- This Take always succeeds immediately
-        xSemaphoreTake(gTX_sem, portMAX_DELAY);
+// -- Assign the RMT memory blocks to channels
+//    A channel with N blocks uses the memory of the next N-1 RMT
+//    channels too, so the channels are laid out one after the other.
+void ESP32RMTController::planChannels()
+{
+    if ( ! FASTLED_RMT_ADAPTIVE_MEM_BLOCKS || FASTLED_RMT_BUILTIN_DRIVER) return;
+    if (gNumShowing == 0) return;
+
+    // -- Longest strips first: they get the biggest channels, and
+    //    starting them first keeps the total time down when there are
+    //    more strips than channels
+    for (int i = 1; i < gNumShowing; i++) {
+        ESP32RMTController * pController = gShowing[i];
+        int j = i;
+        while (j > 0 && gShowing[j-1]->mSize < pController->mSize) {
+            gShowing[j] = gShowing[j-1];
+            j--;
+        }
+        gShowing[j] = pController;
+    }
 
-        // -- Make sure it's been at least 50us since last show
-        // this is very conservative if you have multiple channels,
-        // arguably there should be a wait on the startnext of each LED string
-        gWait.wait();
+    // -- Smallest channel that absorbs the worst latency seen so far,
+    //    with a 2x margin. A refill that is more than 3/4 of a fill
+    //    late gets abandoned (see timingOk).
+    uint32_t cyclesPerBit = gShowing[0]->mCyclesPerBit;
+    for (int i = 1; i < gNumShowing; i++) {
+        if (gShowing[i]->mCyclesPerBit < cyclesPerBit) cyclesPerBit = gShowing[i]->mCyclesPerBit;
+    }
+    int minBlocks = MEM_BLOCK_NUM;
+    while ( (minBlocks < 8) && ((gMaxLateCycles * 2) > ((32 * minBlocks * cyclesPerBit * 3) / 4)) ) {
+        minBlocks++;
+    }
 
-        // -- First, fill all the available channels and start them
-        int channel = 0;
-        while ( (channel < FASTLED_RMT_MAX_CHANNELS) && (gNext < gNumControllers) ) {
+    int numChannels = 8 / minBlocks;
+    if (numChannels > FASTLED_RMT_MAX_CHANNELS) numChannels = FASTLED_RMT_MAX_CHANNELS;
+    if (numChannels > gNumShowing) numChannels = gNumShowing;
 
-            ESP32RMTController::startNext(channel);
+    int blocks[8];
+    int spare = 8;
+    for (int ch = 0; ch < numChannels; ch++) {
+        blocks[ch] = minBlocks;
+        spare -= minBlocks;
+    }
 
-            channel++;
+    // -- Hand out the leftover blocks one at a time, to the channels
+    //    whose first strip does not fit in the buffer. Each 32-bit
+    //    word of pixel data is 32 pulses, a block holds 64.
+    bool gave = true;
+    while (spare > 0 && gave) {
+        gave = false;
+        for (int ch = 0; (ch < numChannels) && (spare > 0); ch++) {
+            if (gShowing[ch]->mSize * 32 > blocks[ch] * 64) {
+                blocks[ch]++;
+                spare--;
+                gave = true;
+            }
         }
+    }
 
-        // -- Wait here while the data is sent. The interrupt handler
-        //    will keep refilling the RMT buffers until it is all
-        //    done; then it gives the semaphore back.
-        xSemaphoreTake(gTX_sem, portMAX_DELAY);
-        xSemaphoreGive(gTX_sem);
+    // -- Lay the channels out, touching the hardware only for RMT
+    //    channels whose memory size changes
+    int rmt_channel = 0;
+    for (int ch = 0; ch < numChannels; ch++) {
+        gChannelRMT[ch] = rmt_channel_t(rmt_channel);
+        gChannelBlocks[ch] = blocks[ch];
 
-        // -- Make sure we don't call showPixels too quickly
-        gWait.mark();
+        if (gRMTBlocks[rmt_channel] != blocks[ch]) {
+            gRMTBlocks[rmt_channel] = blocks[ch];
+            rmt_set_mem_block_num(rmt_channel_t(rmt_channel), blocks[ch]);
+#if USE_FASTLED_RMT_FNS
+            fastled_set_tx_thr_intr_en(rmt_channel_t(rmt_channel), true, 32 * blocks[ch]);
+#else
+            rmt_set_tx_thr_intr_en(rmt_channel_t(rmt_channel), true, 32 * blocks[ch]);
+#endif
+        }
+
+        rmt_channel += blocks[ch];
+    }
+
+    gNumChannels = numChannels;
+}
 
-        // -- Reset the counters
-        gNumStarted = 0;
-        gNumDone = 0;
-        gNext = 0;
+// -- Wait for the previous show to finish
+//    The semaphore is held for as long as a frame is being sent, so
+//    taking it (and handing it right back) is the wait.
+bool ESP32RMTController::waitForShowDone(TickType_t ticks)
+{
+    if ( ! gShowPending) return true;
+
+    if (xSemaphoreTake(gTX_sem, ticks) != pdTRUE) return false;
+    xSemaphoreGive(gTX_sem);
+
+    gShowPending = false;
+
+    // -- Make sure we don't call showPixels too quickly
+    gWait.mark();
 
 #if FASTLED_ESP32_FLASH_LOCK == 1
-        // -- Release the lock on flash operations
-        spi_flash_op_unlock();
+    // -- Release the lock on flash operations
+    spi_flash_op_unlock();
 #endif
 
-#if FASTLED_ESP32_SHOWTIMING == 1
-        // the interrupts may have dumped things to the buffer. Print it.
-        // warning: this does a fairly large stack allocation. 
-        char mb[MEMORYBUF_SIZE+1];
-        int mb_len = MEMORYBUF_SIZE;
-        memorybuf_get(mb, &mb_len);
-        if (mb_len > 0) {
-           mb[mb_len] = 0;
-           printf(" rmt irq print: %s\n",mb);
-       }
-#endif /* FASTLED_ESP32_SHOWTIMING == 1 */
+    return true;
+}
 
+// -- Register a function to call when a frame has been sent
+void ESP32RMTController::setShowDoneCallback(rmt_show_done_fn fn, void * arg)
+{
+    gShowDoneArg = arg;
+    gShowDoneFn = fn;
+}
+
+// -- Read the timing statistics
+void ESP32RMTController::getStats(ESP32RMTStats * stats)
+{
+    *stats = gStats;
+
+    for (int i = 0; i < FASTLED_RMT_MAX_CHANNELS; i++) {
+        stats->channel[i].maxLateUs = CYCLES_TO_US(gChannelMaxLateCycles[i]);
     }
+    stats->maxIsrNs = (uint32_t) (((uint64_t) gMaxIsrCycles * 1000) / (F_CPU / 1000000L));
+    stats->bytesPerSec = stats->sendUs ? (uint32_t) ((stats->bytes * 1000000) / stats->sendUs) : 0;
+}
 
+// -- Start collecting the timing statistics from zero
+void ESP32RMTController::resetStats()
+{
+    memset(&gStats, 0, sizeof(gStats));
+    memset(gChannelMaxLateCycles, 0, sizeof(gChannelMaxLateCycles));
+    gMaxIsrCycles = 0;
 }
 
 // -- Start up the next controller
@@ -409,8 +582,8 @@ void ESP32RMTController::showPixels()
 //    appropriate startOnChannel method of the given controller.
 void ESP32RMTController::startNext(int channel)
 {
-    if (gNext < gNumControllers) {
-        ESP32RMTController * pController = gControllers[gNext];
+    if (gNext < gNumShowing) {
+        ESP32RMTController * pController = gShowing[gNext];
         pController->startOnChannel(channel);
         gNext++;
     }
@@ -425,16 +598,23 @@ void ESP32RMTController::startOnChannel(int channel)
     // -- Store a reference to this controller, so we can get it
     //    inside the interrupt handler
     gOnChannel[channel] = this;
+    mChannel = channel;
+    mAborted = false;
 
-    // the RMT channel depends on the MEM_BLOCK
-    mRMT_channel = rmt_channel_t(channel * MEM_BLOCK_NUM);
+    // the RMT channel depends on the memory blocks given to the channel
+    mRMT_channel = gChannelRMT[channel];
+
+    // -- Refill every half buffer
+    mPulsesPerFill = 32 * gChannelBlocks[channel];
+    mCyclesPerFill = mCyclesPerBit * mPulsesPerFill;
+    mMaxCyclesPerFill = mCyclesPerFill + ((mCyclesPerFill * 3)/4);
 
     // -- Assign the pin to this channel
     rmt_set_pin(mRMT_channel, RMT_MODE_TX, mPin);
 
     if (FASTLED_RMT_BUILTIN_DRIVER) {
         // -- Use the built-in RMT driver to send all the data in one shot
-        rmt_register_tx_end_callback(doneOnRMTChannel, (void *) channel);
+        rmt_register_tx_end_callback(doneOnRMTChannel, (void *) (intptr_t) channel);
         rmt_write_items(mRMT_channel, mBuffer, mBufferSize, false);
     } else {
         // -- Use our custom driver to send the data incrementally
@@ -463,6 +643,29 @@ void ESP32RMTController::startOnChannel(int channel)
 
 }
 
+// -- Hold the line low before a retry
+//    The strip stays on the same channel. One item holds the line low
+//    for the latch time (split across its two halves, since each is
+//    only 15 bits), and a zero item ends the transmission.
+void ESP32RMTController::startLatch()
+{
+    const uint32_t ticks = (RMT_CYCLES_PER_SEC / 1000000L) * FASTLED_RMT_RETRY_LATCH_US / 2;
+    static_assert((RMT_CYCLES_PER_SEC / 1000000L) * FASTLED_RMT_RETRY_LATCH_US / 2 < (1 << 15),
+                  "FASTLED_RMT_RETRY_LATCH_US is too long for one RMT item");
+    rmt_item32_t latch;
+    latch.level0 = 0;
+    latch.duration0 = ticks;
+    latch.level1 = 0;
+    latch.duration1 = ticks;
+
+    mLatching = true;
+    mRMT_mem_start = & (RMTMEM.chan[mRMT_channel].data32[0].val);
+    mRMT_mem_start[0] = latch.val;
+    mRMT_mem_start[1] = 0;
+
+    tx_start();
+}
+
 // -- Start RMT transmission
 //    Setting this RMT flag is what actually kicks off the peripheral
 void ESP32RMTController::tx_start()
@@ -481,7 +684,7 @@ void ESP32RMTController::tx_start()
 // so we use the arg instead
 void ESP32RMTController::doneOnRMTChannel(rmt_channel_t channel, void * arg) 
 {
-    doneOnChannel((int) arg, (void *) 0);
+    doneOnChannel((int) (intptr_t) arg, (void *) 0);
 }
 
 // -- A controller is done 
@@ -493,15 +696,44 @@ void ESP32RMTController::doneOnRMTChannel(rmt_channel_t channel, void * arg)
 void ESP32RMTController::doneOnChannel(int channel, void * arg)
 {
 
+    ESP32RMTController * pController = gOnChannel[channel];
+
+    // -- A strip that was cut short gets resent on the same channel,
+    //    after holding the line low long enough for the LEDs to latch
+    if (pController->mLatching) {
+        pController->mLatching = false;
+        pController->startOnChannel(channel);
+        return;
+    }
+    if (pController->mAborted) {
+        if (pController->mRetries < FASTLED_RMT_MAX_RETRIES) {
+            pController->mRetries++;
+            gStats.channel[channel].retries++;
+            pController->startLatch();
+            return;
+        }
+        gFrameLost = true;
+        pController->mStripValid = false;
+    }
+
     // -- Turn off output on the pin
-    // SZG: Do I really need to do this?
-    //  ESP32RMTController * pController = gOnChannel[channel];
-    // gpio_matrix_out(pController->mPin, 0x100, 0, 0);
+    //    Otherwise it stays connected to the channel, and also gets
+    //    the next strip sent on it
+    gpio_matrix_out(pController->mPin, 0x100, 0, 0);
 
     gOnChannel[channel] = NULL;
     gNumDone++;
 
-    if (gNumDone == gNumControllers) {
+    if (gNumDone == gNumShowing) {
+        gStats.frames++;
+        gStats.bytes += gFrameBytes;
+        gStats.sendUs += CYCLES_TO_US(__clock_cycles() - gFrameStartCycles);
+        if (gFrameAborted) gStats.abortedFrames++;
+        if (gFrameLost) gStats.lostFrames++;
+
+        // -- Tell the application before anyone else can start a frame
+        if (gShowDoneFn) gShowDoneFn(gShowDoneArg);
+
         // -- If this is the last controller, signal that we are all done
         if (FASTLED_RMT_BUILTIN_DRIVER) {
             xSemaphoreGive(gTX_sem);
@@ -513,7 +745,7 @@ void ESP32RMTController::doneOnChannel(int channel, void * arg)
     } else {
         // -- Otherwise, if there are still controllers waiting, then
         //    start the next one on this channel
-        if (gNext < gNumControllers) {
+        if (gNext < gNumShowing) {
             startNext(channel);
         }
     }
@@ -526,12 +758,14 @@ void ESP32RMTController::doneOnChannel(int channel, void * arg)
 void IRAM_ATTR ESP32RMTController::interruptHandler(void *arg)
 {
 
+    uint32_t start = __clock_cycles();
+
     // -- The basic structure of this code is borrowed from the
     //    interrupt handler in esp-idf/components/driver/rmt.c
     uint32_t intr_st = RMT.int_st.val;
     uint8_t channel;
 
-    for (channel = 0; channel < FASTLED_RMT_MAX_CHANNELS; channel++) {
+    for (channel = 0; channel < gNumChannels; channel++) {
 
         ESP32RMTController * pController = gOnChannel[channel];
         if (pController != NULL) {
@@ -560,9 +794,10 @@ void IRAM_ATTR ESP32RMTController::interruptHandler(void *arg)
             }
         }
     }
-}
 
-DRAM_ATTR char g_bail_str[] = "_BAIL_";
+    uint32_t cycles = __clock_cycles() - start;
+    if (cycles > gMaxIsrCycles) gMaxIsrCycles = cycles;
+}
 
 // check to see if there's a bad timing. Returns
 // we may be behind the necessary timing, so we should bail out of this 'show'.
@@ -576,17 +811,25 @@ bool IRAM_ATTR ESP32RMTController::timingOk() {
 
     uint32_t delta = __clock_cycles() - mLastFill;
 
+    // -- Record how late this refill is. The worst ever is also
+    //    used by planChannels().
+    uint32_t late = (delta > mCyclesPerFill) ? (delta - mCyclesPerFill) : 0;
+    if (late > gMaxLateCycles) gMaxLateCycles = late;
+
+    ESP32RMTChannelStats & stats = gStats.channel[mChannel];
+    stats.refills++;
+    if (late > gChannelMaxLateCycles[mChannel]) gChannelMaxLateCycles[mChannel] = late;
+    uint32_t late_us = CYCLES_TO_US(late);
+    int bucket = late_us ? (32 - __builtin_clz(late_us)) : 0;
+    if (bucket >= FASTLED_RMT_LATENCY_BUCKETS) bucket = FASTLED_RMT_LATENCY_BUCKETS - 1;
+    stats.latency[bucket]++;
+
     // interesting test - what if we only write 4? will nothing else light?
     if ( delta > mMaxCyclesPerFill) {
 
-#if FASTLED_ESP32_SHOWTIMING == 1
-        memorybuf_add('!');
-        memorybuf_int( CYCLES_TO_US(delta), '-' );
-        memorybuf_int( CYCLES_TO_US(mMaxCyclesPerFill), '-');
-        memorybuf_int( mCur, ':' );
-        memorybuf_int( mSize, ':' );
-        memorybuf_add( g_bail_str );
-#endif /* FASTLED_ESP32_SHOWTIMING == 1 */
+        stats.aborts++;
+        gFrameAborted = true;
+        mAborted = true;
 
         // how do we bail out? It seems if we simply call rmt_tx_stop, 
         // we'll still flicker on the end. Setting mCur to mSize has the side effect
@@ -596,21 +839,11 @@ bool IRAM_ATTR ESP32RMTController::timingOk() {
         mCur = mSize;
 
         // other code also set some zeros to make sure there wasn't anything bad.
-        fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_SW);
-        for (uint32_t j = 0; j < PULSES_PER_FILL; j++) {
-            * mRMT_mem_ptr++ = 0;
-        }
-        fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_HW);
+        fillEnd();
 
         return false;
     }
 
-#if FASTLED_ESP32_SHOWTIMING == 1
-    else {
-        memorybuf_int( CYCLES_TO_US(delta), '-' );
-    }
-#endif /* FASTLED_ESP32_SHOWTIMING == 1 */
-
     return true;
 }
 
@@ -637,14 +870,30 @@ void IRAM_ATTR ESP32RMTController::fillNext()
         // Shift bits out, MSB first, setting RMTMEM.chan[n].data32[x] to the 
         // rmt_item32_t value corresponding to the buffered bit value
 
-        for (int i=0; i < PULSES_PER_FILL / 32; i++) {
+        for (int i=0; i < mPulsesPerFill / 32; i++) {
             if (mCur < mSize) {
                 register uint32_t thispixel = mPixelData[mCur];
-                for (int j = 0; j < 32; j++) {
-
-                    *pItem++ = (thispixel & 0x80000000L) ? one_val : zero_val;
-                    // Replaces: RMTMEM.chan[mRMT_channel].data32[mCurPulse].val = val;
-                    thispixel <<= 1;
+                if (mByteItems) {
+                    // -- Copy 8 precomputed items per byte
+                    for (int shift = 24; shift >= 0; shift -= 8) {
+                        const uint32_t * pSrc = mByteItems + (((thispixel >> shift) & 0xFF) << 3);
+                        pItem[0] = pSrc[0];
+                        pItem[1] = pSrc[1];
+                        pItem[2] = pSrc[2];
+                        pItem[3] = pSrc[3];
+                        pItem[4] = pSrc[4];
+                        pItem[5] = pSrc[5];
+                        pItem[6] = pSrc[6];
+                        pItem[7] = pSrc[7];
+                        pItem += 8;
+                    }
+                } else {
+                    for (int j = 0; j < 32; j++) {
+
+                        *pItem++ = (thispixel & 0x80000000L) ? one_val : zero_val;
+                        // Replaces: RMTMEM.chan[mRMT_channel].data32[mCurPulse].val = val;
+                        thispixel <<= 1;
+                    }
                 }
                 mCur++;
             }
@@ -672,14 +921,26 @@ void IRAM_ATTR ESP32RMTController::fillNext()
 
     } else {
         // -- No more data; signal to the RMT we are done
-        fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_SW);
-        for (uint32_t j = 0; j < PULSES_PER_FILL; j++) {
-            * mRMT_mem_ptr++ = 0;
-        }
-        fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_HW);
+        fillEnd();
     }
 }
 
+// -- Fill the next half of the RMT buffer with end markers
+void IRAM_ATTR ESP32RMTController::fillEnd()
+{
+    fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_SW);
+    for (int j = 0; j < mPulsesPerFill; j++) {
+        * mRMT_mem_ptr++ = 0;
+    }
+
+    mWhichHalf++;
+    if (mWhichHalf == 2) {
+        mRMT_mem_ptr = mRMT_mem_start;
+        mWhichHalf = 0;
+    }
+    fastled_set_mem_owner(mRMT_channel, RMT_MEM_OWNER_HW);
+}
+
 // -- Init pulse buffer
 //    Set up the buffer that will hold all of the pulse items for this
 //    controller. 
@@ -707,6 +968,12 @@ void ESP32RMTController::initPulseBuffer(int size_in_bytes)
 void ESP32RMTController::convertByte(uint32_t byteval)
 {
     // -- Write one byte's worth of RMT pulses to the big buffer
+    if (mByteItems) {
+        memcpy(& mBuffer[mCurPulse], mByteItems + ((byteval & 0xFF) << 3), 8 * sizeof(uint32_t));
+        mCurPulse += 8;
+        return;
+    }
+
     byteval <<= 24;
     for (uint32_t j = 0; j < 8; j++) {
         mBuffer[mCurPulse] = (byteval & 0x80000000L) ? mOne : mZero;
@@ -34,6 +34,11 @@
  * send the data for 8 controllers simultaneously, but 16 controllers
  * would take approximately twice as much time.
  *
+ * The frame is sent once every controller has been shown, which is
+ * what FastLED.show() does. To send only some of the controllers, use
+ * FastLED.flushLeds(), which brackets the showLeds() calls with
+ * beginFlush() and flush() so the driver knows where the frame ends.
+ *
  * There is a #define that allows a program to control the total
  * number of channels that the driver is allowed to use. It defaults
  * to 8 -- use all the channels. Setting it to 1, for example, results
@@ -41,6 +46,19 @@
  *
  *     #define FASTLED_RMT_MAX_CHANNELS 1
  *
+ * MEMORY BLOCKS: Each channel normally gets MEM_BLOCK_NUM of the 8
+ * RMT memory blocks, which limits the number of channels to
+ * 8 / MEM_BLOCK_NUM. Define this flag to plan the blocks at show time
+ * instead:
+ *
+ *     #define FASTLED_RMT_ADAPTIVE_MEM_BLOCKS 1
+ *
+ * Every channel starts with 1 block, so up to 8 strips go out at
+ * once. Channels get more blocks when the refill interrupts have been
+ * seen running late (e.g. under WiFi or BLE load), and blocks that
+ * are left over go to the longest strips. Only the custom driver does
+ * this; the built-in driver keeps fixed blocks.
+ *
  * OTHER RMT APPLICATIONS
  *
  * The default FastLED driver takes over control of the RMT interrupt
@@ -81,6 +99,67 @@
  *      send the data while the program continues to prepare the next
  *      frame of data.
  *
+ * BYTE LOOKUP TABLE: Each data bit becomes one 32-bit RMT item, and
+ *      the interrupt handler normally picks the "one" or "zero" item
+ *      bit by bit. Define this flag to precompute the 8 items for all
+ *      256 byte values instead, so that a refill is just a table
+ *      lookup and 8 word copies per byte:
+ *
+ *      #define FASTLED_RMT_BYTE_LUT 1
+ *
+ *      The table is 8KB. Controllers with identical timing (e.g. all
+ *      WS2812 strips) share one table.
+ *
+ * ASYNCHRONOUS SHOW: Because the pixel data is copied (and scaled)
+ *      into a private buffer before it is sent, the caller's CRGB
+ *      array is free as soon as the copy is made. Define this flag to
+ *      have show() return as soon as the transmission has started,
+ *      instead of blocking until the last bit is out:
+ *
+ *      #define FASTLED_RMT_ASYNC_SHOW 1
+ *
+ *      The next show() waits for the previous frame to finish before
+ *      touching the buffers. To find out when a frame is done, either
+ *      call ESP32RMTController::waitForShowDone(), or register a
+ *      function with ESP32RMTController::setShowDoneCallback(). With
+ *      the custom driver the callback runs inside the RMT interrupt
+ *      handler, so it must be short and marked IRAM_ATTR.
+ *
+ * RETRANSMISSION: With the custom driver, a strip is cut short when a
+ *      refill interrupt comes so late that the RMT would send garbage
+ *      (see timingOk). The strip then shows a mix of old and new
+ *      pixels until the next frame. Define this flag to resend such a
+ *      strip from its pixel buffer, up to the given number of times
+ *      per frame:
+ *
+ *      #define FASTLED_RMT_MAX_RETRIES 2
+ *
+ *      Before each retry the line is held low for
+ *      FASTLED_RMT_RETRY_LATCH_US microseconds (300 by default, enough
+ *      for the newer WS2812B parts, and at most 1638) so the LEDs
+ *      latch the partial frame and start over. Retries are counted in
+ *      the statistics.
+ *
+ * DIRTY PREFIX: WS281x strips keep showing the last data they got, so
+ *      if only the start of a strip changed there is no need to send
+ *      the rest. Define this flag to compare each frame with the
+ *      previous one and stop sending after the last changed pixel:
+ *
+ *      #define FASTLED_RMT_DIRTY_PREFIX 1
+ *
+ *      The cut is rounded up to a multiple of 4 pixels (3 for RGBW),
+ *      so it always falls on a pixel boundary. The first frame, and
+ *      the frame after a strip was cut short by a late refill, are
+ *      sent in full. This only works with the custom driver, and only
+ *      helps when temporal dithering is off (FastLED.setDither(0)),
+ *      since dithering changes the data every frame.
+ *
+ * RGBW: Clockless controllers take an EWhiteMode template parameter
+ *      (see SK6812RGBWController in chipsets.h). For RGBW chipsets the
+ *      white byte is computed from the scaled pixel while the data is
+ *      loaded, so there is no intermediate RGBW copy of the LEDs, and
+ *      each 32-bit word of the buffer holds exactly one pixel.
+ *
  * Based on public domain code created 19 Nov 2016 by Chris Osborn <fozztexx@fozztexx.com>
  * http://insentricity.com *
  *
@@ -118,8 +197,10 @@ extern "C" {
 #include "driver/gpio.h"
 #include "driver/rmt.h"
 #include "driver/periph_ctrl.h"
+#include "esp_heap_caps.h"
 #include "freertos/semphr.h"
 #include "soc/rmt_struct.h"
+#include "xtensa/hal.h"
 
 #include "esp_log.h"
 
@@ -132,7 +213,11 @@ extern void spi_flash_op_unlock(void);
 
 __attribute__ ((always_inline)) inline static uint32_t __clock_cycles() {
   uint32_t cyc;
+#ifdef __XTENSA__
   __asm__ __volatile__ ("rsr %0,ccount":"=a" (cyc));
+#else
+  cyc = xthal_get_ccount();
+#endif
   return cyc;
 }
 
@@ -140,15 +225,29 @@ __attribute__ ((always_inline)) inline static uint32_t __clock_cycles() {
 #define NUM_COLOR_CHANNELS 3
 
 
+// -- Core or custom driver
+#ifndef FASTLED_RMT_BUILTIN_DRIVER
+#define FASTLED_RMT_BUILTIN_DRIVER false
+#endif
+
 // -- Configuration constants
 #define DIVIDER             2 /* 4, 8 still seem to work, but timings become marginal */
                                 /* there is no point in higher dividers, as this parameter only needs to make
                                    sure the scaling factors of the RMT intervals fit in 15 bits. */
 
+// -- Plan the number of memory blocks per channel at show time
+#ifndef FASTLED_RMT_ADAPTIVE_MEM_BLOCKS
+#define FASTLED_RMT_ADAPTIVE_MEM_BLOCKS 0
+#endif
+
+#if FASTLED_RMT_ADAPTIVE_MEM_BLOCKS && ! FASTLED_RMT_BUILTIN_DRIVER
+#define MEM_BLOCK_NUM       1 /* the smallest channel; the planner hands out the rest */
+#else
 #define MEM_BLOCK_NUM       2 /* the number of memory blocks. There are 8 for the entire RMT system, and nominally
                                 1 per channel. Using a larger number reduces the number of hardware channels that can be used
                                 at one time, but increases the resistance to RTOS interrupt jitter. 1 seems to be good enough,
                                 but jitter created by wifi might still cause glitches and 2 or more may be reuired. */
+#endif
 #define PULSES_PER_CHANNEL  (64 * MEM_BLOCK_NUM) /* A channel has a 64 "pulse" buffer of 32 bits (aka Items in RMT interface) */
 #define PULSES_PER_FILL     (PULSES_PER_CHANNEL / 2)     /* Half of the channel buffer */
                             // PPF must be a multipel of 32 or fillNext must be re-coded
@@ -169,10 +268,6 @@ __attribute__ ((always_inline)) inline static uint32_t __clock_cycles() {
 #define NS_TO_CYCLES(n)             ( (n) / NS_PER_CYCLE )
 #define RMT_RESET_DURATION          NS_TO_CYCLES(50000)
 
-// -- Core or custom driver
-#ifndef FASTLED_RMT_BUILTIN_DRIVER
-#define FASTLED_RMT_BUILTIN_DRIVER false
-#endif
 
 // -- Max number of controllers we can support
 #ifndef FASTLED_RMT_MAX_CONTROLLERS
@@ -190,10 +285,59 @@ __attribute__ ((always_inline)) inline static uint32_t __clock_cycles() {
 // doesn't seem to make any postitive difference
 //#define FASTLED_ESP32_FLASH_LOCK 1
 
-#ifndef FASTLED_ESP32_SHOWTIMING
-#define FASTLED_ESP32_SHOWTIMING 0
+// -- Timing statistics, see ESP32RMTController::getStats()
+//    Refill latency is how much later than expected a refill
+//    interrupt ran. Bucket 0 counts refills less than 1us late, and
+//    bucket N counts refills 2^(N-1) to 2^N - 1 us late; the last
+//    bucket counts everything beyond.
+#define FASTLED_RMT_LATENCY_BUCKETS 8
+
+struct ESP32RMTChannelStats {
+    uint32_t refills;       // refill interrupts handled on this channel
+    uint32_t aborts;        // strips cut short because a refill was too late
+    uint32_t retries;       // strips resent after being cut short
+    uint32_t maxLateUs;     // worst refill latency
+    uint32_t latency[FASTLED_RMT_LATENCY_BUCKETS];
+};
+
+struct ESP32RMTStats {
+    ESP32RMTChannelStats channel[FASTLED_RMT_MAX_CHANNELS];
+    uint32_t frames;        // frames sent
+    uint32_t abortedFrames; // frames in which at least one strip was cut short
+    uint32_t lostFrames;    // frames in which a strip was still cut short after all retries
+    uint32_t maxIsrNs;      // longest time spent in the interrupt handler
+    uint64_t bytes;         // pixel data bytes sent
+    uint64_t sendUs;        // time from the start of each frame until its last strip is done
+    uint32_t bytesPerSec;   // bytes / sendUs: the throughput while sending
+};
+
+// -- Precompute the RMT items for every byte value
+#ifndef FASTLED_RMT_BYTE_LUT
+#define FASTLED_RMT_BYTE_LUT 0
+#endif
+
+// -- Return from show() as soon as the transmission is started
+#ifndef FASTLED_RMT_ASYNC_SHOW
+#define FASTLED_RMT_ASYNC_SHOW 0
+#endif
+
+// -- Resend strips that were cut short
+#ifndef FASTLED_RMT_MAX_RETRIES
+#define FASTLED_RMT_MAX_RETRIES 0
+#endif
+
+#ifndef FASTLED_RMT_RETRY_LATCH_US
+#define FASTLED_RMT_RETRY_LATCH_US 300
 #endif
 
+// -- Only send the strip up to the last changed pixel
+#ifndef FASTLED_RMT_DIRTY_PREFIX
+#define FASTLED_RMT_DIRTY_PREFIX 0
+#endif
+
+// -- Called when all of the controllers have finished sending a frame
+typedef void (*rmt_show_done_fn)(void * arg);
+
 class ESP32RMTController
 {
 private:
@@ -204,6 +348,9 @@ private:
     // are 0, 2, 4, 6.... etc
     rmt_channel_t  mRMT_channel;
 
+    // -- Our channel number, as opposed to the RMT channel
+    int            mChannel;
+
     // -- Store the GPIO pin
     gpio_num_t     mPin;
 
@@ -211,17 +358,39 @@ private:
     rmt_item32_t   mZero;
     rmt_item32_t   mOne;
 
-    // -- Total expected time to send 32 bits
+    // -- The 8 RMT items for each byte value, MSB first
+    //    Only allocated when FASTLED_RMT_BYTE_LUT is set; may be
+    //    shared with other controllers that have the same timing.
+    uint32_t *     mByteItems;
+
+    // -- CPU cycles to send one bit
+    uint32_t       mCyclesPerBit;
+
+    // -- Pulses sent between refills: half the channel's buffer
+    int            mPulsesPerFill;
+
+    // -- Total expected time to send mPulsesPerFill bits
     //    Each strip should get an interrupt roughly at this interval
     uint32_t       mCyclesPerFill;
     uint32_t       mMaxCyclesPerFill;
     uint32_t       mLastFill;
 
     // -- Pixel data
+    //    mSize is the number of words to send this frame, which is
+    //    less than mDataSize when only a prefix changed
     uint32_t *     mPixelData;
+    int            mDataSize;
     int            mSize;
     int            mCur;
 
+    // -- Does the strip show what is in mPixelData?
+    bool           mStripValid;
+
+    // -- Retransmission state for the current frame
+    int            mRetries;
+    bool           mAborted;
+    bool           mLatching;
+
     // -- RMT memory
     volatile uint32_t * mRMT_mem_ptr;
     volatile uint32_t * mRMT_mem_start;
@@ -240,12 +409,20 @@ public:
     //    member variables.
     ESP32RMTController(int DATA_PIN, int T1, int T2, int T3);
 
+    // -- Build (or share) the byte lookup table
+    void initByteItems();
+
     // -- Get max cycles per fill
     uint32_t IRAM_ATTR getMaxCyclesPerFill() const { return mMaxCyclesPerFill; }
 
     // -- Get or create the pixel data buffer
     uint32_t * getPixelBuffer(int size_in_bytes);
 
+    // -- Only send the first words of the pixel buffer
+    //    Called after loading the pixel data, with the number of
+    //    words up to and including the last one that changed.
+    void setDirtyWords(int words);
+
     // -- Initialize RMT subsystem
     //    This only needs to be done once
     static void init();
@@ -254,6 +431,43 @@ public:
     //    This is the main entry point for the pixel controller
     void IRAM_ATTR showPixels();
 
+    // -- Batched output
+    //    Between beginFlush() and flush(), showPixels only records the
+    //    controller; flush() then sends exactly those controllers.
+    //    Without a flush, the frame starts once every controller has
+    //    been shown. flush() does not wait for the frame; waitFlush()
+    //    does, unless FASTLED_RMT_ASYNC_SHOW is set.
+    static void beginFlush();
+    static void flush();
+    static void waitFlush();
+
+    // -- Send all of the controllers that have been shown
+    //    If wait is set, return once they have been sent.
+    static void startShow(bool wait);
+
+    // -- Assign the RMT memory blocks to channels
+    //    With FASTLED_RMT_ADAPTIVE_MEM_BLOCKS, this sizes each channel
+    //    according to the strips in this frame and the worst refill
+    //    latency seen so far. Otherwise every channel gets MEM_BLOCK_NUM.
+    static void planChannels();
+
+    // -- Wait for the previous show to finish
+    //    Only blocks when FASTLED_RMT_ASYNC_SHOW is set and a frame is
+    //    still being sent. Returns false if it timed out.
+    static bool waitForShowDone(TickType_t ticks = portMAX_DELAY);
+
+    // -- Register a function to call when a frame has been sent
+    //    Pass NULL to remove it.
+    static void setShowDoneCallback(rmt_show_done_fn fn, void * arg);
+
+    // -- Read the timing statistics
+    //    These are collected all the time by the interrupt handler. The
+    //    copy is not atomic, so counters may be a refill apart.
+    static void getStats(ESP32RMTStats * stats);
+
+    // -- Start collecting the timing statistics from zero
+    static void resetStats();
+
     // -- Start up the next controller
     //    This method is static so that it can dispatch to the
     //    appropriate startOnChannel method of the given controller.
@@ -264,6 +478,11 @@ public:
     //    for it to finish.
     void IRAM_ATTR startOnChannel(int channel);
 
+    // -- Hold the line low before a retry
+    //    Sends a single low item of FASTLED_RMT_RETRY_LATCH_US; when it
+    //    is done, doneOnChannel starts the strip over.
+    void IRAM_ATTR startLatch();
+
     // -- Start RMT transmission
     //    Setting this RMT flag is what actually kicks off the peripheral
     void IRAM_ATTR tx_start();
@@ -306,6 +525,11 @@ public:
     //    long to hold the signal high, followed by how long to hold it low.
     void IRAM_ATTR fillNext();
 
+    // -- Fill the next half of the RMT buffer with end markers
+    //    Wraps around like fillNext(), so that it never writes past
+    //    the memory of this channel.
+    void IRAM_ATTR fillEnd();
+
     // -- Init pulse buffer
     //    Set up the buffer that will hold all of the pulse items for this
     //    controller. 
@@ -317,7 +541,7 @@ public:
     void convertByte(uint32_t byteval);
 };
 
-template <int DATA_PIN, int T1, int T2, int T3, EOrder RGB_ORDER = RGB, int XTRA0 = 0, bool FLIP = false, int WAIT_TIME = 5>
+template <int DATA_PIN, int T1, int T2, int T3, EOrder RGB_ORDER = RGB, int XTRA0 = 0, bool FLIP = false, int WAIT_TIME = 5, EWhiteMode WHITE = RGBW_NONE>
 class ClocklessController : public CPixelLEDController<RGB_ORDER>
 {
 private:
@@ -328,6 +552,9 @@ private:
     // -- This instantiation forces a check on the pin choice
     FastPin<DATA_PIN> mFastPin;
 
+    // -- RGBW chipsets send a white byte after each pixel
+    enum { BYTES_PER_PIXEL = (WHITE == RGBW_NONE) ? 3 : 4 };
+
 public:
 
     ClocklessController()
@@ -341,6 +568,11 @@ public:
 
     virtual uint16_t getMaxRefreshRate() const { return 400; }
 
+    virtual void beginFlush() { ESP32RMTController::beginFlush(); }
+    virtual bool holdsUntilFlush() const { return true; }
+    virtual void flush() { ESP32RMTController::flush(); }
+    virtual void waitFlush() { ESP32RMTController::waitFlush(); }
+
 protected:
 
     // -- Load pixel data
@@ -348,54 +580,165 @@ protected:
     //    by the RMT driver. Copying does two important jobs: it fixes the color
     //    order for the pixels, and it performs the scaling/adjusting ahead of time.
     //    It also packs the bytes into 32 bit chunks with the right bit order.
+    //    For RGBW chipsets each chunk is exactly one pixel.
     void loadPixelData(PixelController<RGB_ORDER> & pixels)
     {
         // -- Make sure the buffer is allocated
-        int size_in_bytes = pixels.size() * 3;
+        int size_in_bytes = pixels.size() * BYTES_PER_PIXEL;
         uint32_t * pData = mRMTController.getPixelBuffer(size_in_bytes);
 
-        // -- Read out the pixel data using the pixel controller methods that
-        //    perform the scaling and adjustments 
+        // -- The dithering mode is the same for the whole frame, so pick
+        //    the loop that does (or skips) it once, up front
+        int dirty;
+#if FASTLED_TEMPORAL_DITHER
+        if (pixels.mErr) {
+            dirty = packPixels<TEMPORAL_DITHER>(pixels, pData);
+        } else
+#endif
+        if (pixels.e[0] | pixels.e[1] | pixels.e[2]) {
+            dirty = packPixels<BINARY_DITHER>(pixels, pData);
+        } else {
+            dirty = packPixels<DISABLE_DITHER>(pixels, pData);
+        }
+
+        if (FASTLED_RMT_DIRTY_PREFIX) mRMTController.setDirtyWords(dirty);
+    }
+
+    // -- Scale, dither, reorder and pack the pixels in one pass
+    //    This does the same work as loadAndScale0/1/2, advanceData and
+    //    stepDithering for each pixel, but with the color order, the
+    //    scale and the dither state held in locals. Four RGB pixels
+    //    make three words, so the main loop does four at a time. With
+    //    FASTLED_SCALE_LUT the scale is a lookup in the controller's tables.
+    //    Returns the number of words up to the last one that changed.
+    template <int DITHER>
+    int packPixels(PixelController<RGB_ORDER> & pixels, uint32_t * pData)
+    {
+        const uint8_t * p = pixels.mData;
+        const int advance = pixels.mAdvance;
+        int n = pixels.mLenRemaining;
+
+        // -- TEMPORAL_DITHER scales by the plain value and carries each
+        //    pixel's rounding error over to the next frame
+        uint8_t * err = NULL;
+#if FASTLED_TEMPORAL_DITHER
+        if (DITHER == TEMPORAL_DITHER) err = pixels.pixelErr();
+#endif
+        const uint8_t t0 = pixels.mScale.raw[RO(0)];
+        const uint8_t t1 = pixels.mScale.raw[RO(1)];
+        const uint8_t t2 = pixels.mScale.raw[RO(2)];
+
+#if FASTLED_SCALE_LUT
+        const uint8_t * s0 = pixels.mLUT + RO(0) * 256;
+        const uint8_t * s1 = pixels.mLUT + RO(1) * 256;
+        const uint8_t * s2 = pixels.mLUT + RO(2) * 256;
+#define FASTLED_RMT_SCALE(b, s) s[b]
+#else
+        const uint8_t s0 = pixels.mScale.raw[RO(0)];
+        const uint8_t s1 = pixels.mScale.raw[RO(1)];
+        const uint8_t s2 = pixels.mScale.raw[RO(2)];
+#define FASTLED_RMT_SCALE(b, s) scale8(b, s)
+#endif
+        const uint8_t e0 = pixels.e[RO(0)];
+        const uint8_t e1 = pixels.e[RO(1)];
+        const uint8_t e2 = pixels.e[RO(2)];
+        uint8_t d0 = pixels.d[RO(0)];
+        uint8_t d1 = pixels.d[RO(1)];
+        uint8_t d2 = pixels.d[RO(2)];
+
+        uint8_t b[12];
         int count = 0;
-        int which = 0;
-        while (pixels.has(1)) {
-            // -- Get the next four bytes of data
-            uint8_t four[4] = {0,0,0,0};
-            for (int i = 0; i < 4; i++) {
-                switch (which) {
-                case 0: 
-                    four[i] = pixels.loadAndScale0();
-                    break;
-                case 1:
-                    four[i] = pixels.loadAndScale1();
-                    break;
-                case 2:
-                    four[i] = pixels.loadAndScale2();
-                    pixels.advanceData();
-                    pixels.stepDithering();
-                    break;
-                }
-                // -- Move to the next color
-                which++;
-                if (which > 2) which = 0;
+        int dirty = 0;
+
+        // -- Scale and dither the next pixel into b[i..i+2]
+#define FASTLED_RMT_LOAD_PIXEL(i)                                       \
+        b[(i)]   = p[RO(0)];                                            \
+        b[(i)+1] = p[RO(1)];                                            \
+        b[(i)+2] = p[RO(2)];                                            \
+        if (DITHER == TEMPORAL_DITHER) {                                \
+            b[(i)]   = PixelController<RGB_ORDER>::scaleTemporal(b[(i)], t0, err + RO(0));   \
+            b[(i)+1] = PixelController<RGB_ORDER>::scaleTemporal(b[(i)+1], t1, err + RO(1)); \
+            b[(i)+2] = PixelController<RGB_ORDER>::scaleTemporal(b[(i)+2], t2, err + RO(2)); \
+            err += 3;                                                   \
+        } else {                                                        \
+            if (DITHER == BINARY_DITHER) {                              \
+                if (b[(i)])   b[(i)]   = qadd8(b[(i)], d0);             \
+                if (b[(i)+1]) b[(i)+1] = qadd8(b[(i)+1], d1);           \
+                if (b[(i)+2]) b[(i)+2] = qadd8(b[(i)+2], d2);           \
+                d0 = e0 - d0;                                           \
+                d1 = e1 - d1;                                           \
+                d2 = e2 - d2;                                           \
+            }                                                           \
+            b[(i)]   = FASTLED_RMT_SCALE(b[(i)], s0);                   \
+            b[(i)+1] = FASTLED_RMT_SCALE(b[(i)+1], s1);                 \
+            b[(i)+2] = FASTLED_RMT_SCALE(b[(i)+2], s2);                 \
+        }                                                               \
+        p += advance;
+
+#define FASTLED_RMT_STORE_WORD(word)                                    \
+        {                                                               \
+            uint32_t w32 = (word);                                      \
+            if (FASTLED_RMT_DIRTY_PREFIX && pData[count] != w32) dirty = count + 1; \
+            pData[count++] = w32;                                       \
+        }
 
-                // -- Stop if there's no more data
-                if ( ! pixels.has(1)) break;
+        if (WHITE != RGBW_NONE) {
+            for ( ; n > 0; n--) {
+                FASTLED_RMT_LOAD_PIXEL(0);
+                uint8_t w = 0;
+                if (WHITE != RGBW_OFF) {
+                    w = b[0] < b[1] ? b[0] : b[1];
+                    if (b[2] < w) w = b[2];
+                    if (WHITE == RGBW_EXACT) { b[0] -= w; b[1] -= w; b[2] -= w; }
+                }
+                FASTLED_RMT_STORE_WORD(b[0] << 24 | b[1] << 16 | b[2] << 8 | w);
+            }
+        } else {
+            for ( ; n >= 4; n -= 4) {
+                FASTLED_RMT_LOAD_PIXEL(0);
+                FASTLED_RMT_LOAD_PIXEL(3);
+                FASTLED_RMT_LOAD_PIXEL(6);
+                FASTLED_RMT_LOAD_PIXEL(9);
+                FASTLED_RMT_STORE_WORD(b[0] << 24 | b[1] << 16 | b[2] << 8 | b[3]);
+                FASTLED_RMT_STORE_WORD(b[4] << 24 | b[5] << 16 | b[6] << 8 | b[7]);
+                FASTLED_RMT_STORE_WORD(b[8] << 24 | b[9] << 16 | b[10] << 8 | b[11]);
             }
 
-            // -- Pack the four bytes into a 32-bit value with the right bit order
-            uint8_t a = four[0];
-            uint8_t b = four[1];
-            uint8_t c = four[2];
-            uint8_t d = four[3];
-            pData[count++] = a << 24 | b << 16 | c << 8 | d;
+            // -- Up to three pixels left over: pad the last word with zeros
+            if (n > 0) {
+                memset(b, 0, sizeof(b));
+                for (int i = 0; i < n; i++) {
+                    FASTLED_RMT_LOAD_PIXEL(i * 3);
+                }
+                int words = ((n * 3) + 3) / 4;
+                for (int i = 0; i < words; i++) {
+                    FASTLED_RMT_STORE_WORD(b[i*4] << 24 | b[i*4+1] << 16 | b[i*4+2] << 8 | b[i*4+3]);
+                }
+                n = 0;
+            }
         }
+
+#undef FASTLED_RMT_SCALE
+#undef FASTLED_RMT_LOAD_PIXEL
+#undef FASTLED_RMT_STORE_WORD
+
+        // -- Leave the pixel controller as if we had stepped through it
+        pixels.mData = p;
+        pixels.mLenRemaining = 0;
+        pixels.d[RO(0)] = d0;
+        pixels.d[RO(1)] = d1;
+        pixels.d[RO(2)] = d2;
+
+        return dirty;
     }
 
     // -- Show pixels
     //    This is the main entry point for the controller.
     virtual void showPixels(PixelController<RGB_ORDER> & pixels)
     {
+        // -- The buffers may still be in use by the previous frame
+        ESP32RMTController::waitForShowDone();
+
         if (FASTLED_RMT_BUILTIN_DRIVER) {
             convertAllPixelData(pixels);
         } else {
@@ -413,19 +756,28 @@ protected:
     void convertAllPixelData(PixelController<RGB_ORDER> & pixels)
     {
         // -- Make sure the data buffer is allocated
-        mRMTController.initPulseBuffer(pixels.size() * 3);
+        mRMTController.initPulseBuffer(pixels.size() * BYTES_PER_PIXEL);
 
         // -- Cycle through the R,G, and B values in the right order,
         //    storing the pulses in the big buffer
 
         uint32_t byteval;
         while (pixels.has(1)) {
-            byteval = pixels.loadAndScale0();
-            mRMTController.convertByte(byteval);
-            byteval = pixels.loadAndScale1();
-            mRMTController.convertByte(byteval);
-            byteval = pixels.loadAndScale2();
-            mRMTController.convertByte(byteval);
+            if (WHITE != RGBW_NONE) {
+                uint8_t a, b, c;
+                uint8_t w = pixels.template loadAndScaleRGBW<WHITE>(a, b, c);
+                mRMTController.convertByte(a);
+                mRMTController.convertByte(b);
+                mRMTController.convertByte(c);
+                mRMTController.convertByte(w);
+            } else {
+                byteval = pixels.loadAndScale0();
+                mRMTController.convertByte(byteval);
+                byteval = pixels.loadAndScale1();
+                mRMTController.convertByte(byteval);
+                byteval = pixels.loadAndScale2();
+                mRMTController.convertByte(byteval);
+            }
             pixels.advanceData();
             pixels.stepDithering();
         }
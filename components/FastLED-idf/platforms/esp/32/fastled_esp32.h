@@ -8,6 +8,7 @@
 
 #ifdef FASTLED_ESP32_I2S
 #include "clockless_i2s_esp32.h"
+#include "clocked_i2s_esp32.h"
 #else
 #include "clockless_rmt_esp32.h"
 #endif
@@ -18,12 +18,32 @@ FASTLED_NAMESPACE_BEGIN
  *
  * #define FASTLED_ALL_PINS_HARDWARE_SPI
  *
- * This driver uses the VSPI bus by default (GPIO 18, 19, 23, & 5). To use the 
- * HSPI bus (GPIO 14, 12, 13, & 15) add the following line *before* including
- * FastLED.h:
+ * This driver uses the VSPI bus by default. To use the HSPI bus add the
+ * following line *before* including FastLED.h:
  * 
- * #define FASTLED_ESP32_SPI_BUS HSPI
+ * #define FASTLED_ESP32_SPI_BUS HSPI_HOST
  * 
+ * The data and clock pins of the first controller are routed to the bus.
+ * Any pin works, but the native VSPI pins (23 data, 18 clock) or HSPI pins
+ * (13 data, 14 clock) allow the highest clock rates. All SPI strips share
+ * the bus, so they should use the same two pins.
+ *
+ * DMA: Rather than sending one byte at a time, the driver collects
+ * everything a controller writes between select() and release() -- start
+ * frame, brightness headers, pixels and end frame -- in a DMA capable
+ * buffer, and sends it as a single transaction. The buffer grows up to
+ * FASTLED_ESP32_SPI_MAX_BYTES; longer frames are sent in pieces of that
+ * size. The DMA channel is set with FASTLED_ESP32_SPI_DMA_CHANNEL.
+ *
+ * ASYNCHRONOUS SHOW: There are two buffers. Define
+ *
+ *   #define FASTLED_ESP32_SPI_ASYNC 1
+ *
+ * to return from show() as soon as the frame is queued. The next frame
+ * is encoded into the other buffer while this one is sent, and only
+ * waits if it catches up with the hardware. Controllers with a select
+ * pin are always sent synchronously, since the pin is released when
+ * show() returns.
  */
 /*
  * Permission is hereby granted, free of charge, to any person obtaining a copy
@@ -45,44 +65,219 @@ FASTLED_NAMESPACE_BEGIN
  * THE SOFTWARE.
  */
 
+#include "driver/spi_master.h"
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+
+// -- Which SPI host to use
 #ifndef FASTLED_ESP32_SPI_BUS
-    #define FASTLED_ESP32_SPI_BUS VSPI
+#define FASTLED_ESP32_SPI_BUS VSPI_HOST
+#endif
+
+// -- DMA channel for the SPI host (1 or 2)
+#ifndef FASTLED_ESP32_SPI_DMA_CHANNEL
+#define FASTLED_ESP32_SPI_DMA_CHANNEL 1
 #endif
 
-SPIClass ledSPI(FASTLED_ESP32_SPI_BUS);
-
-#if FASTLED_ESP32_SPI_BUS == VSPI
-    static uint8_t spiClk = 18;
-    static uint8_t spiMiso = 19;
-    static uint8_t spiMosi = 23;
-    static uint8_t spiCs = 5;
-#elif FASTLED_ESP32_SPI_BUS == HSPI
-    static uint8_t spiClk = 14;
-    static uint8_t spiMiso = 12;
-    static uint8_t spiMosi = 13;
-    static uint8_t spiCs = 15;
+// -- Largest single transaction, in bytes
+#ifndef FASTLED_ESP32_SPI_MAX_BYTES
+#define FASTLED_ESP32_SPI_MAX_BYTES 32768
 #endif
 
+// -- Return from show() while the frame is still being sent
+#ifndef FASTLED_ESP32_SPI_ASYNC
+#define FASTLED_ESP32_SPI_ASYNC 0
+#endif
+
+// -- Smallest buffer we bother allocating
+#define SPI_MIN_BUFFER_BYTES 256
+
+// -- Devices one SPI host can have
+#define SPI_MAX_DEVICES 3
+
+// -- One of the two transmit buffers
+//    A buffer is busy from the time it is queued until its result has
+//    been collected from the device it was queued on.
+struct ESP32SPIBuffer {
+    uint8_t *           data;
+    int                 size;
+    spi_transaction_t   trans;
+    spi_device_handle_t device;
+    bool                busy;
+};
+
+// -- A device on the bus, and the clock rate it was added with
+struct ESP32SPIDevice {
+    int                 clock_hz;
+    spi_device_handle_t handle;
+};
+
+// -- Global SPI state, shared by all controllers
+static bool                gSPIBusReady = false;
+static int                 gSPIDataPin = -1;
+static int                 gSPIClockPin = -1;
+static ESP32SPIBuffer      gSPIBuffers[2];
+static int                 gSPICur = 0;
+static spi_device_handle_t gSPIDevice = NULL;
+
+// -- One device per clock rate, shared by all controllers that use it
+static ESP32SPIDevice      gSPIDevices[SPI_MAX_DEVICES];
+static int                 gSPINumDevices = 0;
+
+// -- Write position in the current buffer
+//    gSPIDropping is set when the buffer could not grow; the rest of
+//    the frame is dropped.
+static uint8_t *           gSPIPos = NULL;
+static uint8_t *           gSPIEnd = NULL;
+static bool                gSPIDropping = false;
+
+// -- Get the device for a clock rate, adding it to the bus if needed
+//    Returns NULL if the bus has no room for another one.
+static spi_device_handle_t spiGetDevice(int clock_hz)
+{
+    for (int i = 0; i < gSPINumDevices; i++) {
+        if (gSPIDevices[i].clock_hz == clock_hz) return gSPIDevices[i].handle;
+    }
+
+    if (gSPINumDevices == SPI_MAX_DEVICES) {
+        ESP_LOGE("FastLED", "SPI: at most %d different clock rates", SPI_MAX_DEVICES);
+        return NULL;
+    }
+
+    spi_device_interface_config_t dev;
+    memset(&dev, 0, sizeof(dev));
+    dev.mode = 0;
+    dev.clock_speed_hz = clock_hz;
+    dev.spics_io_num = -1;
+    dev.queue_size = 2;
+    ESP32SPIDevice & d = gSPIDevices[gSPINumDevices++];
+    d.clock_hz = clock_hz;
+    ESP_ERROR_CHECK(spi_bus_add_device(FASTLED_ESP32_SPI_BUS, &dev, &d.handle));
+    return d.handle;
+}
+
+// -- Wait until the buffer has been sent
+static void spiWaitBuffer(ESP32SPIBuffer & b)
+{
+    if (b.busy) {
+        spi_transaction_t * done;
+        spi_device_get_trans_result(b.device, &done, portMAX_DELAY);
+        b.busy = false;
+    }
+}
+
+// -- Wait until nothing is being sent
+//    Call this before changing the pixels of an asynchronous show if
+//    the previous frame must not see them, or before sleeping.
+static void spiWaitForShowDone()
+{
+    spiWaitBuffer(gSPIBuffers[0]);
+    spiWaitBuffer(gSPIBuffers[1]);
+}
+
+// -- Start writing into the current buffer
+static void spiBeginBuffer()
+{
+    ESP32SPIBuffer & b = gSPIBuffers[gSPICur];
+    spiWaitBuffer(b);
+    gSPIPos = b.data;
+    gSPIEnd = b.data + b.size;
+    gSPIDropping = false;
+}
+
+// -- Queue the current buffer, then move on to the other one
+static void spiSendBuffer(bool wait)
+{
+    ESP32SPIBuffer & b = gSPIBuffers[gSPICur];
+    int len = gSPIPos - b.data;
+    if (len > 0 && gSPIDevice != NULL) {
+        memset(&b.trans, 0, sizeof(b.trans));
+        b.trans.length = len * 8;
+        b.trans.tx_buffer = b.data;
+        b.device = gSPIDevice;
+        b.busy = (spi_device_queue_trans(gSPIDevice, &b.trans, portMAX_DELAY) == ESP_OK);
+        if (wait) spiWaitBuffer(b);
+        gSPICur = 1 - gSPICur;
+    }
+    spiBeginBuffer();
+}
+
+// -- Make room for at least one more byte
+//    Grow the buffer if it is below the limit, otherwise send what we
+//    have and continue in the other buffer. Returns false if there is
+//    no DMA memory to grow it: the byte, and the rest of the frame,
+//    must be dropped.
+static bool spiMakeRoom()
+{
+    if (gSPIDropping) return false;
+
+    ESP32SPIBuffer & b = gSPIBuffers[gSPICur];
+    if (b.size < FASTLED_ESP32_SPI_MAX_BYTES) {
+        int len = gSPIPos - b.data;
+        int size = b.size ? b.size * 2 : SPI_MIN_BUFFER_BYTES;
+        if (size > FASTLED_ESP32_SPI_MAX_BYTES) size = FASTLED_ESP32_SPI_MAX_BYTES;
+        uint8_t * data = (uint8_t *) heap_caps_malloc(size, MALLOC_CAP_DMA);
+        if (data == NULL) {
+            ESP_LOGE("FastLED", "SPI: no DMA memory for a %d byte buffer, dropping the rest of the frame", size);
+            gSPIDropping = true;
+            return false;
+        }
+        if (len) memcpy(data, b.data, len);
+        heap_caps_free(b.data);
+        b.data = data;
+        b.size = size;
+        gSPIPos = data + len;
+        gSPIEnd = data + size;
+        return true;
+    }
+
+    // -- The other buffer may not have been allocated yet
+    spiSendBuffer(false);
+    if (gSPIPos < gSPIEnd) return true;
+    return spiMakeRoom();
+}
+
 template <uint8_t DATA_PIN, uint8_t CLOCK_PIN, uint32_t SPI_SPEED>
 class ESP32SPIOutput {
 	Selectable 	*m_pSelect;
+	spi_device_handle_t m_device;
 
 public:
-	ESP32SPIOutput() { m_pSelect = NULL; }
-	ESP32SPIOutput(Selectable *pSelect) { m_pSelect = pSelect; }
+	ESP32SPIOutput() { m_pSelect = NULL; m_device = NULL; }
+	ESP32SPIOutput(Selectable *pSelect) { m_pSelect = pSelect; m_device = NULL; }
 	void setSelect(Selectable *pSelect) { m_pSelect = pSelect; }
 
 	void init() {
-		// set the pins to output and make sure the select is released (which apparently means hi?  This is a bit
-		// confusing to me)
-		ledSPI.begin(spiClk, spiMiso, spiMosi, spiCs);
+		if ( ! gSPIBusReady) {
+			spi_bus_config_t bus;
+			memset(&bus, 0, sizeof(bus));
+			bus.mosi_io_num = DATA_PIN;
+			bus.miso_io_num = -1;
+			bus.sclk_io_num = CLOCK_PIN;
+			bus.quadwp_io_num = -1;
+			bus.quadhd_io_num = -1;
+			bus.max_transfer_sz = FASTLED_ESP32_SPI_MAX_BYTES;
+			ESP_ERROR_CHECK(spi_bus_initialize(FASTLED_ESP32_SPI_BUS, &bus, FASTLED_ESP32_SPI_DMA_CHANNEL));
+			gSPIBusReady = true;
+			gSPIDataPin = DATA_PIN;
+			gSPIClockPin = CLOCK_PIN;
+		} else if (DATA_PIN != gSPIDataPin || CLOCK_PIN != gSPIClockPin) {
+			// -- The bus only has one pair of pins, so this strip gets
+			//    the data meant for the first one's pins
+			ESP_LOGE("FastLED", "SPI: strips must share data pin %d and clock pin %d", gSPIDataPin, gSPIClockPin);
+		}
+
+		// -- SPI_SPEED is a divider of the CPU clock (see DATA_RATE_MHZ)
+		m_device = spiGetDevice(F_CPU / SPI_SPEED);
+
 		release();
 	}
 
 	// stop the SPI output.  Pretty much a NOP with software, as there's no registers to kick
 	static void stop() { }
 
-	// wait until the SPI subsystem is ready for more data to write.  A NOP when bitbanging
+	// wait until the SPI subsystem is ready for more data to write.  A NOP here, since
+	// data goes into the buffer
 	static void wait() __attribute__((always_inline)) { }
 	static void waitFully() __attribute__((always_inline)) { wait(); }
 
@@ -91,27 +286,30 @@ public:
 
 	static void writeWord(uint16_t w) __attribute__((always_inline)) { writeByte(w>>8); writeByte(w&0xFF); }
 
-	// naive writeByte implelentation, simply calls writeBit on the 8 bits in the byte.
-	static void writeByte(uint8_t b) {
-		ledSPI.transfer(b);
+	// append a byte to the frame buffer
+	static void writeByte(uint8_t b) __attribute__((always_inline)) {
+		if (gSPIPos == gSPIEnd && ! spiMakeRoom()) return;
+		*gSPIPos++ = b;
 	}
 
 public:
 
-	// select the SPI output (TODO: research whether this really means hi or lo.  Alt TODO: move select responsibility out of the SPI classes
-	// entirely, make it up to the caller to remember to lock/select the line?)
+	// select the SPI output: start a new frame in the current buffer
 	void select() { 
-		ledSPI.beginTransaction(SPISettings(SPI_SPEED, MSBFIRST, SPI_MODE0));
+		gSPIDevice = m_device;
+		spiBeginBuffer();
 		if(m_pSelect != NULL) { m_pSelect->select(); } 
 	} 
 
-	// release the SPI line
+	// release the SPI line: send the frame
 	void release() { 
+		if (gSPIDevice == m_device) {
+			spiSendBuffer( ! FASTLED_ESP32_SPI_ASYNC || m_pSelect != NULL);
+		}
 		if(m_pSelect != NULL) { m_pSelect->release(); } 
-		ledSPI.endTransaction();
 	}
 
-	// Write out len bytes of the given value out over ledSPI.  Useful for quickly flushing, say, a line of 0's down the line.
+	// Write out len bytes of the given value out over SPI.  Useful for quickly flushing, say, a line of 0's down the line.
 	void writeBytesValue(uint8_t value, int len) {
 		select();
 		writeBytesValueRaw(value, len);
@@ -120,7 +318,7 @@ public:
 
 	static void writeBytesValueRaw(uint8_t value, int len) {
 		while(len--) {
-			ledSPI.transfer(value); 
+			writeByte(value); 
 		}
 	}
 
@@ -141,7 +339,7 @@ public:
 
 	// write a single bit out, which bit from the passed in byte is determined by template parameter
 	template <uint8_t BIT> inline void writeBit(uint8_t b) {
-		ledSPI.transfer(b);
+		writeByte(b);
 	}
 
 	// write a block of uint8_ts out in groups of three.  len is the total number of uint8_ts to write out.  The template
@@ -165,4 +363,4 @@ public:
 	}
 };
 
-FASTLED_NAMESPACE_END
\ No newline at end of file
+FASTLED_NAMESPACE_END
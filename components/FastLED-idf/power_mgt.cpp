@@ -47,6 +47,22 @@ static const uint8_t gMCU_mW  =  25 * 5; // 25mA @ 5v = 125 mW
 static uint8_t  gMaxPowerIndicatorLEDPinNumber = 0; // default = Arduino onboard LED pin.  set to zero to skip this.
 
 
+// Power at full brightness, from the sums of each channel over the leds
+static uint32_t power_mW( uint32_t red32, uint32_t green32, uint32_t blue32, uint16_t numLeds )
+{
+    red32   *= gRed_mW;
+    green32 *= gGreen_mW;
+    blue32  *= gBlue_mW;
+
+    red32   >>= 8;
+    green32 >>= 8;
+    blue32  >>= 8;
+
+    uint32_t total = red32 + green32 + blue32 + (gDark_mW * numLeds);
+
+    return total;
+}
+
 uint32_t calculate_unscaled_power_mW( const CRGB* ledbuffer, uint16_t numLeds ) //25354
 {
     uint32_t red32 = 0, green32 = 0, blue32 = 0;
@@ -63,17 +79,25 @@ uint32_t calculate_unscaled_power_mW( const CRGB* ledbuffer, uint16_t numLeds )
         count--;
     }
 
-    red32   *= gRed_mW;
-    green32 *= gGreen_mW;
-    blue32  *= gBlue_mW;
+    return power_mW( red32, green32, blue32, numLeds);
+}
 
-    red32   >>= 8;
-    green32 >>= 8;
-    blue32  >>= 8;
+uint32_t calculate_unscaled_power_mW( const CRGB16* ledbuffer, uint16_t numLeds )
+{
+    uint32_t red32 = 0, green32 = 0, blue32 = 0;
+    const CRGB16* p = ledbuffer;
 
-    uint32_t total = red32 + green32 + blue32 + (gDark_mW * numLeds);
+    uint16_t count = numLeds;
 
-    return total;
+    while( count) {
+        red32   += p->r >> 8;
+        green32 += p->g >> 8;
+        blue32  += p->b >> 8;
+        p++;
+        count--;
+    }
+
+    return power_mW( red32, green32, blue32, numLeds);
 }
 
 
@@ -103,7 +127,12 @@ uint8_t calculate_max_brightness_for_power_mW( uint8_t target_brightness, uint32
 
     CLEDController *pCur = CLEDController::head();
 	while(pCur) {
-        total_mW += calculate_unscaled_power_mW( pCur->leds(), pCur->size());
+        // 16 bit data is what gets sent, rather than the CRGB array
+        if( pCur->leds16()) {
+            total_mW += calculate_unscaled_power_mW( pCur->leds16(), pCur->size());
+        } else {
+            total_mW += calculate_unscaled_power_mW( pCur->leds(), pCur->size());
+        }
 		pCur = pCur->next();
 	}
 
@@ -0,0 +1,177 @@
+#define FASTLED_INTERNAL
+#include "FastLED.h"
+#include "freertos/task.h"
+
+#if FASTLED_TELEMETRY
+
+FASTLED_NAMESPACE_BEGIN
+
+void CTimeStats::add(uint32_t micros) {
+	if(m_nCount == 0 || micros < m_nMin) { m_nMin = micros; }
+	if(micros > m_nMax) { m_nMax = micros; }
+	m_nCount++;
+	m_nTotal += micros;
+
+	uint8_t b = bucket(micros);
+	if(++m_Hist[b] == 0xFFFF) {
+		for(int i = 0; i < BUCKETS; i++) {
+			m_Hist[i] >>= 1;
+		}
+	}
+}
+
+void CTimeStats::reset() {
+	m_nCount = 0;
+	m_nMin = 0;
+	m_nMax = 0;
+	m_nTotal = 0;
+	memset(m_Hist, 0, sizeof(m_Hist));
+}
+
+// Buckets 0-7 hold their own value; after that, four buckets per power of two from 8 up, the last one open ended
+uint8_t CTimeStats::bucket(uint32_t micros) {
+	if(micros < 8) { return micros; }
+	int exp = 31 - __builtin_clz(micros);
+	if(exp > 16) { return BUCKETS - 1; }
+	return 8 + (exp - 3) * 4 + ((micros >> (exp - 2)) & 3);
+}
+
+uint32_t CTimeStats::bucketTop(uint8_t bucket) {
+	if(bucket < 8) { return bucket; }
+	if(bucket >= BUCKETS - 1) { return 0xFFFFFFFF; }
+	int exp = 3 + (bucket - 8) / 4;
+	int sub = (bucket - 8) % 4;
+	return ((uint32_t)(5 + sub) << (exp - 2)) - 1;
+}
+
+uint32_t CTimeStats::percentile(uint8_t pct) const {
+	uint32_t total = 0;
+	for(int i = 0; i < BUCKETS; i++) {
+		total += m_Hist[i];
+	}
+	if(total == 0) { return 0; }
+
+	// the smallest bucket that holds at least pct percent of the values
+	uint32_t want = (total * pct + 99) / 100;
+	uint32_t seen = 0;
+	int i = 0;
+	for(; i < BUCKETS - 1; i++) {
+		seen += m_Hist[i];
+		if(seen >= want && seen > 0) { break; }
+	}
+
+	uint32_t top = bucketTop(i);
+	if(top < m_nMin) { return m_nMin; }
+	if(top > m_nMax) { return m_nMax; }
+	return top;
+}
+
+// The statistics are updated in one go at the end of a frame, between two increments of m_nSeq, so that it is odd
+// while they change.  Readers on other tasks copy them, and try again if m_nSeq was odd or moved in the meantime.
+// They yield while they wait, in case the task in show() runs on the same core.
+void CTelemetry::copy(CTelemetry & out) const {
+	uint32_t seq;
+	do {
+		while((seq = m_nSeq) & 1) { taskYIELD(); }
+		__sync_synchronize();
+		out = *this;
+		__sync_synchronize();
+	} while(seq != m_nSeq);
+}
+
+void CTelemetry::copy(const CLEDController & controller, CTimeStats & encode, CTimeStats & wire) const {
+	uint32_t seq;
+	do {
+		while((seq = m_nSeq) & 1) { taskYIELD(); }
+		__sync_synchronize();
+		encode = controller.m_Times.encode;
+		wire = controller.m_Times.wire;
+		__sync_synchronize();
+	} while(seq != m_nSeq);
+}
+
+void CTelemetry::beginFrame() {
+	uint32_t now = micros();
+	m_Frame.start = now;
+	m_Frame.micros[RENDER] = m_nFrames ? (now - m_nLast) : 0;
+	m_nLast = now;
+}
+
+void CTelemetry::mark(EPhase phase) {
+	uint32_t now = micros();
+	m_Frame.micros[phase] = now - m_nLast;
+	m_nLast = now;
+}
+
+void CTelemetry::endFrame() {
+	mark(WIRE);
+
+	m_nSeq++;
+	__sync_synchronize();
+
+	if(m_bReset) {
+		m_bReset = false;
+		clear();
+	}
+
+	for(int i = 0; i < PHASES; i++) {
+		m_Stats[i].add(m_Frame.micros[i]);
+	}
+	m_Frames[m_nFrames % FASTLED_TELEMETRY_FRAMES] = m_Frame;
+	m_nFrames++;
+
+	CLEDController *pCur = CLEDController::head();
+	while(pCur) {
+		CControllerTimes & t = pCur->m_Times;
+		if(t.shown) {
+			t.encode.add(t.encodeMicros);
+			t.wire.add(t.wireMicros);
+			t.encodeMicros = t.wireMicros = 0;
+			t.shown = false;
+		}
+		pCur = pCur->next();
+	}
+
+	__sync_synchronize();
+	m_nSeq++;
+}
+
+void CTelemetry::clear() {
+	for(int i = 0; i < PHASES; i++) {
+		m_Stats[i].reset();
+	}
+	m_nFrames = 0;
+
+	CLEDController *pCur = CLEDController::head();
+	while(pCur) {
+		pCur->m_Times.encode.reset();
+		pCur->m_Times.wire.reset();
+		pCur = pCur->next();
+	}
+}
+
+void CTelemetry::shown(CLEDController *pController, bool held, uint32_t start) {
+	CControllerTimes & t = pController->m_Times;
+	uint32_t took = micros() - start;
+	if(held) {
+		t.encodeMicros += took;
+	} else {
+		t.wireMicros += took;
+	}
+	t.shown = true;
+}
+
+void CTelemetry::sent(CLEDController *pController, uint32_t start) {
+	pController->m_Times.sendStart = start;
+}
+
+void CTelemetry::flushed(CLEDController *pController, bool held) {
+	CControllerTimes & t = pController->m_Times;
+	if(held && t.shown) {
+		t.wireMicros += micros() - t.sendStart;
+	}
+}
+
+FASTLED_NAMESPACE_END
+
+#endif
@@ -0,0 +1,154 @@
+#ifndef __INC_TELEMETRY_H
+#define __INC_TELEMETRY_H
+
+///@file telemetry.h
+/// timing statistics for FastLED.show(), enabled with FASTLED_TELEMETRY
+
+#include "FastLED.h"
+#include "led_sysdefs.h"
+
+FASTLED_NAMESPACE_BEGIN
+
+/// How many of the most recent frames CTelemetry keeps, each with the time of every phase
+#ifndef FASTLED_TELEMETRY_FRAMES
+#define FASTLED_TELEMETRY_FRAMES 32
+#endif
+
+class CLEDController;
+
+/// Running statistics for a duration in µs: count, min, max, average, and a histogram for percentiles.  Values
+/// below 8 get a bucket each; above that, every power of two is split into four buckets, so a percentile is at
+/// most 25% above the true value.  The last bucket takes everything from 114688µs up.  When a bucket fills up,
+/// all of them are halved, so the percentiles lean towards recent frames, while the minimum, maximum and average
+/// cover everything since the last reset().
+class CTimeStats {
+public:
+	enum { BUCKETS = 64 };
+
+	CTimeStats() { reset(); }
+
+	/// add one value
+	void add(uint32_t micros);
+
+	/// start over
+	void reset();
+
+	/// @returns the number of values added since the last reset
+	uint32_t count() const { return m_nCount; }
+	/// @returns the smallest value, or 0 if there are none
+	uint32_t minimum() const { return m_nCount ? m_nMin : 0; }
+	/// @returns the largest value
+	uint32_t maximum() const { return m_nMax; }
+	/// @returns the average value, or 0 if there are none
+	uint32_t average() const { return m_nCount ? (uint32_t)(m_nTotal / m_nCount) : 0; }
+
+	/// @param pct - the percentile, 0 to 100
+	/// @returns the top of the bucket holding the given percentile, clamped to minimum() and maximum()
+	uint32_t percentile(uint8_t pct) const;
+
+	/// @returns the histogram bucket for a value
+	static uint8_t bucket(uint32_t micros);
+	/// @returns the largest value that goes into a bucket
+	static uint32_t bucketTop(uint8_t bucket);
+	/// @returns the number of values in a bucket, scaled down along with the others if any filled up
+	uint16_t bucketCount(uint8_t bucket) const { return m_Hist[bucket]; }
+
+private:
+	uint32_t m_nCount;
+	uint32_t m_nMin;
+	uint32_t m_nMax;
+	uint64_t m_nTotal;
+	uint16_t m_Hist[BUCKETS];
+};
+
+/// Per controller times for the frame being sent, and their statistics.  encode is the time spent in showLeds()
+/// by a controller that holds its data until flush(); wire is the time from its flush() until its waitFlush()
+/// returns.  The other controllers write out their data as they go, so all of their showLeds() counts as wire.
+struct CControllerTimes {
+	CTimeStats encode;
+	CTimeStats wire;
+	uint32_t encodeMicros;
+	uint32_t wireMicros;
+	uint32_t sendStart;
+	bool shown;
+
+	CControllerTimes() : encodeMicros(0), wireMicros(0), sendStart(0), shown(false) {}
+};
+
+/// Where the time of each frame went, overall and per controller, kept by FastLED.show(), showColor() and
+/// flushLeds() when FASTLED_TELEMETRY is set.  Each frame is split into phases that add up to the time since
+/// the frame before it:
+///   RENDER - from the end of the last frame until show() was called again, which is the application's time
+///   IDLE   - waiting for the frame to be due, as set by setMaxRefreshRate and setTargetFPS
+///   POWER  - the power limit function
+///   ENCODE - the controllers that hold their data until flush() preparing it
+///   WIRE   - everything after that until the last controller is done
+///
+/// Everything is fixed size, and recording a frame costs a few calls to micros() per controller.  The statistics
+/// are written by the task that calls show(); other tasks (e.g. a status report over the network) should read
+/// them through copy(), which retries until it gets a copy that was not in the middle of an update.  A copy is
+/// about 1.5k, so keep it off small task stacks.
+class CTelemetry {
+public:
+	enum EPhase { RENDER, POWER, ENCODE, WIRE, IDLE, PHASES };
+
+	/// The time of each phase of one frame
+	struct Frame {
+		uint32_t start;			///< micros() when show() was called
+		uint32_t micros[PHASES];	///< µs spent in each phase
+	};
+
+	CTelemetry() : m_nFrames(0), m_nLast(0), m_nSeq(0), m_bReset(false) {}
+
+	/// @returns the statistics of one phase, over all frames
+	const CTimeStats & stats(EPhase phase) const { return m_Stats[phase]; }
+
+	/// @returns the number of frames recorded since the last reset
+	uint32_t frames() const { return m_nFrames; }
+
+	/// @param age - 0 for the most recent frame, up to FASTLED_TELEMETRY_FRAMES - 1 and below frames()
+	/// @returns one of the most recent frames
+	const Frame & frame(int age) const { return m_Frames[(m_nFrames - 1 - age) % FASTLED_TELEMETRY_FRAMES]; }
+
+	/// Copy all of the frame statistics, consistently even while show() runs on another task
+	void copy(CTelemetry & out) const;
+
+	/// Copy the statistics of one controller, consistently even while show() runs on another task
+	void copy(const CLEDController & controller, CTimeStats & encode, CTimeStats & wire) const;
+
+	/// Start over, for all phases and controllers.  Safe to call from any task; it takes effect when the
+	/// current frame is done.
+	void reset() { m_bReset = true; }
+
+	/// @name Recording, used by CFastLED
+	//@{
+	/// the application's render time is over, a frame starts
+	void beginFrame();
+	/// the time since the last mark was spent in the given phase
+	void mark(EPhase phase);
+	/// the last controller is done: the rest of the frame is WIRE
+	void endFrame();
+
+	/// a controller's showLeds() call, started at start, is done
+	static void shown(CLEDController *pController, bool held, uint32_t start);
+	/// a controller that holds its data was flushed at start
+	static void sent(CLEDController *pController, uint32_t start);
+	/// a controller's waitFlush() is done
+	static void flushed(CLEDController *pController, bool held);
+	//@}
+
+private:
+	void clear();
+
+	CTimeStats m_Stats[PHASES];
+	Frame m_Frames[FASTLED_TELEMETRY_FRAMES];
+	Frame m_Frame;
+	uint32_t m_nFrames;
+	uint32_t m_nLast;
+	volatile uint32_t m_nSeq;
+	volatile bool m_bReset;
+};
+
+FASTLED_NAMESPACE_END
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+// -- Shared pieces of the host benchmarks
+//    Host timings only say which way a change goes, not how fast it is
+//    on the ESP32. Each benchmark also checks that the new code gives
+//    the same result as the old one, so it runs as a test too.
+
+#include <chrono>
+
+#include "harness.h"
+
+// -- Best time of a few runs of fn(), in nanoseconds per call
+template <typename F>
+static double timeNs(F fn, int calls)
+{
+    double best = 0;
+    for (int run = 0; run < 5; run++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; i++) fn();
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - start).count() / calls;
+        if (run == 0 || ns < best) best = ns;
+    }
+    return best;
+}
+
+// -- One line of results: old, new, and the ratio
+static inline void report(const char * what, double oldNs, double newNs)
+{
+    printf("  %-32s old %9.1f ns  new %9.1f ns  x%.2f\n", what, oldNs, newNs, oldNs / newNs);
+}
@@ -0,0 +1,81 @@
+// -- The CRGB16 path: showLeds() with setLeds16() data against the
+//    8-bit dither and scale, in each rounding mode. Also checks that
+//    the sketch's CRGB array is left alone, and that the power limit
+//    goes by the 16-bit data.
+
+#include "bench.h"
+#include "power_mgt.h"
+
+#define MAX_LEDS 1024
+
+static CRGB leds[MAX_LEDS];
+static CRGB16 leds16[MAX_LEDS];
+
+// -- A controller that encodes into memory
+class Sink : public CPixelLEDController<RGB> {
+public:
+    uint8_t out[MAX_LEDS * 3];
+
+    virtual void init() {}
+
+protected:
+    virtual void showPixels(PixelController<RGB> & pixels)
+    {
+        uint8_t * p = out;
+        while (pixels.has(1)) {
+            *p++ = pixels.loadAndScale0();
+            *p++ = pixels.loadAndScale1();
+            *p++ = pixels.loadAndScale2();
+            pixels.advanceData();
+            pixels.stepDithering();
+        }
+    }
+};
+
+static Sink sink;
+
+// -- Nanoseconds per pixel for one frame of n leds
+static double perPixel(int n, CRGB16 * data, EDitherMode dither)
+{
+    sink.setLeds(leds, n);
+    sink.setLeds16(data);
+    sink.setDither(dither);
+    return timeNs([&]() { sink.showLeds(15); }, 1000000 / n) / n;
+}
+
+int main()
+{
+    fillRandom(leds, MAX_LEDS);
+    for (int i = 0; i < MAX_LEDS; i++) leds16[i] = CRGB16(leds[i]);
+
+    // -- The 8-bit pixels from the 16-bit ones go to the strip, not
+    //    into the sketch's array
+    static CRGB before[MAX_LEDS];
+    memcpy(before, leds, sizeof(leds));
+    sink.setLeds(leds, MAX_LEDS);
+    sink.setLeds16(leds16);
+    sink.setDither(DISABLE_DITHER);
+    sink.showLeds(255);
+    CHECK(memcmp(before, leds, sizeof(leds)) == 0);
+    CHECK(memcmp(sink.out, leds, sizeof(leds)) == 0);
+
+    // -- The power limit reads the 16-bit data when there is some
+    CHECK(calculate_unscaled_power_mW(leds16, MAX_LEDS) == calculate_unscaled_power_mW(leds, MAX_LEDS));
+    uint8_t limited = calculate_max_brightness_for_power_mW(255, 5000);
+    memset(leds, 0, sizeof(leds));
+    CHECK(calculate_max_brightness_for_power_mW(255, 5000) == limited);
+    CHECK(limited < 255);
+    fillRandom(leds, MAX_LEDS);
+
+    printf("ns per pixel at scale 15\n");
+    printf("  %-6s %12s %12s %12s %12s\n", "leds", "8-bit", "16 nearest", "16 ordered", "16 temporal");
+    for (int n = 256; n <= MAX_LEDS; n *= 4) {
+        double eight    = perPixel(n, NULL, BINARY_DITHER);
+        double nearest  = perPixel(n, leds16, DISABLE_DITHER);
+        double ordered  = perPixel(n, leds16, BINARY_DITHER);
+        double temporal = perPixel(n, leds16, TEMPORAL_DITHER);
+        printf("  %-6d %12.2f %12.2f %12.2f %12.2f\n", n, eight, nearest, ordered, temporal);
+    }
+
+    return finish("bench_crgb16");
+}
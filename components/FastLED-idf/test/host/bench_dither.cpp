@@ -0,0 +1,98 @@
+// -- TEMPORAL_DITHER against BINARY_DITHER (stepDithering)
+//    Times both through the generic PixelController loaders and the
+//    RMT pack loop, and measures how close each gets, averaged over 256
+//    frames, to the exact scaled value of dim pixels.
+
+#include <math.h>
+
+#include "bench.h"
+
+#define NUM_LEDS 300
+#define NUM_FRAMES 256
+
+static CRGB leds[NUM_LEDS];
+static uint8_t err[NUM_LEDS * 3];
+
+// -- A frame the way the controller would start it
+static PixelController<GRB> frame(CRGB scale, EDitherMode dither)
+{
+    PixelController<GRB> pixels(leds, NUM_LEDS, scale, dither == TEMPORAL_DITHER ? DISABLE_DITHER : dither);
+    if (dither == TEMPORAL_DITHER) pixels.mErr = err;
+    return pixels;
+}
+
+// -- The generic loaders, one pixel at a time, into out in wire order
+static void load(PixelController<GRB> pixels, uint8_t * out)
+{
+    while (pixels.has(1)) {
+        *out++ = pixels.loadAndScale0();
+        *out++ = pixels.loadAndScale1();
+        *out++ = pixels.loadAndScale2();
+        pixels.advanceData();
+        pixels.stepDithering();
+    }
+}
+
+// -- Gets at the RMT controller's packPixels()
+class DitherBench : public WS2812<12, GRB> {
+public:
+    template <int DITHER>
+    void pack(PixelController<GRB> pixels, uint32_t * pData)
+    {
+        this->template packPixels<DITHER>(pixels, pData);
+    }
+};
+
+// -- Largest difference, over all bytes, between the average output
+//    and the exact value b * s / 255
+static double averageError(CRGB scale, EDitherMode dither)
+{
+    static uint8_t out[NUM_LEDS * 3];
+    static uint32_t sum[NUM_LEDS * 3];
+    memset(sum, 0, sizeof(sum));
+    for (int f = 0; f < NUM_FRAMES; f++) {
+        load(frame(scale, dither), out);
+        for (int i = 0; i < NUM_LEDS * 3; i++) sum[i] += out[i];
+    }
+
+    double worst = 0;
+    const uint8_t * p = (const uint8_t *) leds;
+    for (int i = 0; i < NUM_LEDS; i++, p += 3) {
+        for (int slot = 0; slot < 3; slot++) {
+            int c = (GRB >> (3 * (2 - slot))) & 3;
+            double exact = p[c] * (double) scale.raw[c] / 255;
+            double e = fabs((double) sum[i * 3 + slot] / NUM_FRAMES - exact);
+            if (e > worst) worst = e;
+        }
+    }
+    return worst;
+}
+
+int main()
+{
+    fillRandom(leds, NUM_LEDS);
+    for (int i = 0; i < NUM_LEDS * 3; i++) err[i] = i * 167;
+
+    static uint8_t bytes[NUM_LEDS * 3];
+    static uint32_t words[NUM_LEDS];
+    DitherBench rmt;
+    CRGB dim(40, 40, 40);
+
+    printf("dithering %d pixels (old: BINARY_DITHER, new: TEMPORAL_DITHER)\n", NUM_LEDS);
+    PixelController<GRB> binary = frame(dim, BINARY_DITHER);
+    PixelController<GRB> temporal = frame(dim, TEMPORAL_DITHER);
+    report("loadAndScale", timeNs([&]() { load(binary, bytes); }, 2000),
+                           timeNs([&]() { load(temporal, bytes); }, 2000));
+    report("RMT packPixels", timeNs([&]() { rmt.pack<BINARY_DITHER>(binary, words); }, 2000),
+                             timeNs([&]() { rmt.pack<TEMPORAL_DITHER>(temporal, words); }, 2000));
+
+    // -- Averaged over the frames, temporal dithering is exact to
+    //    within a step over the number of frames
+    double binaryError = averageError(dim, BINARY_DITHER);
+    double temporalError = averageError(dim, TEMPORAL_DITHER);
+    printf("  worst average error over %d frames at scale 40: binary %.3f, temporal %.3f\n",
+           NUM_FRAMES, binaryError, temporalError);
+    CHECK(temporalError < 2.0 / NUM_FRAMES + 1.0 / 256);
+
+    return finish("bench_dither");
+}
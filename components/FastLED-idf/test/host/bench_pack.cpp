@@ -0,0 +1,107 @@
+// -- RMT pixel packing: packPixels() against the per-byte loop it
+//    replaced, which went through loadAndScale0/1/2 one color at a time
+
+#include "bench.h"
+
+#define NUM_LEDS 300
+
+static CRGB leds[NUM_LEDS];
+
+// -- The old loadPixelData() loop
+template <EOrder RGB_ORDER, EWhiteMode WHITE>
+static int oldPack(PixelController<RGB_ORDER> & pixels, uint32_t * pData)
+{
+    int count = 0;
+    int which = 0;
+    while (pixels.has(1)) {
+        if (WHITE != RGBW_NONE) {
+            uint8_t a, b, c;
+            uint8_t w = pixels.template loadAndScaleRGBW<WHITE>(a, b, c);
+            pixels.advanceData();
+            pixels.stepDithering();
+            pData[count++] = a << 24 | b << 16 | c << 8 | w;
+            continue;
+        }
+
+        uint8_t four[4] = {0,0,0,0};
+        for (int i = 0; i < 4; i++) {
+            switch (which) {
+            case 0:
+                four[i] = pixels.loadAndScale0();
+                break;
+            case 1:
+                four[i] = pixels.loadAndScale1();
+                break;
+            case 2:
+                four[i] = pixels.loadAndScale2();
+                pixels.advanceData();
+                pixels.stepDithering();
+                break;
+            }
+            which++;
+            if (which > 2) which = 0;
+            if ( ! pixels.has(1)) break;
+        }
+        pData[count++] = four[0] << 24 | four[1] << 16 | four[2] << 8 | four[3];
+    }
+    return count;
+}
+
+// -- Gets at the controller's packPixels()
+template <typename BASE, EOrder RGB_ORDER, EWhiteMode WHITE = RGBW_NONE>
+class PackBench : public BASE {
+public:
+    PixelController<RGB_ORDER> frame(const CRGB & scale, EDitherMode dither)
+    {
+        CRGB s = scale;
+        PixelController<RGB_ORDER> pixels(leds, NUM_LEDS, s, dither);
+#if FASTLED_SCALE_LUT
+        pixels.mLUT = this->getLUT(scale);
+#endif
+        return pixels;
+    }
+
+    void run(const char * name, const CRGB & scale, EDitherMode dither)
+    {
+        static uint32_t oldWords[NUM_LEDS];
+        static uint32_t newWords[NUM_LEDS];
+        const PixelController<RGB_ORDER> pixels = frame(scale, dither);
+
+        PixelController<RGB_ORDER> a(pixels);
+        int n = oldPack<RGB_ORDER, WHITE>(a, oldWords);
+        PixelController<RGB_ORDER> b(pixels);
+        pack(b, newWords);
+        CHECK(memcmp(oldWords, newWords, n * 4) == 0);
+        CHECK(a.d[0] == b.d[0] && a.d[1] == b.d[1] && a.d[2] == b.d[2]);
+
+        double oldNs = timeNs([&]() { PixelController<RGB_ORDER> p(pixels); oldPack<RGB_ORDER, WHITE>(p, oldWords); }, 2000);
+        double newNs = timeNs([&]() { PixelController<RGB_ORDER> p(pixels); pack(p, newWords); }, 2000);
+        report(name, oldNs, newNs);
+    }
+
+private:
+    void pack(PixelController<RGB_ORDER> & pixels, uint32_t * pData)
+    {
+        if (pixels.e[0] | pixels.e[1] | pixels.e[2]) {
+            this->template packPixels<BINARY_DITHER>(pixels, pData);
+        } else {
+            this->template packPixels<DISABLE_DITHER>(pixels, pData);
+        }
+    }
+};
+
+int main()
+{
+    fillRandom(leds, NUM_LEDS);
+    printf("packing %d pixels\n", NUM_LEDS);
+
+    PackBench<WS2812<12, GRB>, GRB> grb;
+    grb.run("GRB, no dither", CRGB(255, 255, 255), DISABLE_DITHER);
+    grb.run("GRB, scaled", CRGB(128, 128, 128), DISABLE_DITHER);
+    grb.run("GRB, scaled and dithered", CRGB(128, 128, 128), BINARY_DITHER);
+
+    PackBench<SK6812RGBW<13, GRB>, GRB, FASTLED_RGBW_WHITE_MODE> grbw;
+    grbw.run("GRBW, scaled and dithered", CRGB(128, 128, 128), BINARY_DITHER);
+
+    return finish("bench_pack");
+}
@@ -0,0 +1,94 @@
+// -- I2S bit transpose: transpose24() against the byte-wise
+//    transpose8rS32() it replaced, which wrote each 8x8 block a byte
+//    at a time, 4 bytes apart, and left the rows to be put together
+
+#include "bench.h"
+
+// -- The old transpose of one row, with the strips stored backwards
+//    the way the old fillBuffer() did it
+static void transpose8rS32(const uint8_t * A, int m, int n, uint8_t * B)
+{
+    uint32_t x, y, t;
+
+    x = (A[0]<<24)   | (A[m]<<16)   | (A[2*m]<<8) | A[3*m];
+    y = (A[4*m]<<24) | (A[5*m]<<16) | (A[6*m]<<8) | A[7*m];
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;  x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;  y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >>14)) & 0x0000CCCC;  x = x ^ t ^ (t <<14);
+    t = (y ^ (y >>14)) & 0x0000CCCC;  y = y ^ t ^ (t <<14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    B[0]=x>>24;    B[n]=x>>16;    B[2*n]=x>>8;  B[3*n]=x;
+    B[4*n]=y>>24;  B[5*n]=y>>16;  B[6*n]=y>>8;  B[7*n]=y;
+}
+
+static void oldTranspose(const uint8_t * reversed, uint32_t * bits)
+{
+    uint8_t rows[8][4] = {};
+    transpose8rS32(& reversed[0],  1, 4, & rows[0][0]);
+    transpose8rS32(& reversed[8],  1, 4, & rows[0][1]);
+    transpose8rS32(& reversed[16], 1, 4, & rows[0][2]);
+    for (int k = 0; k < 8; k++) {
+        bits[k] = (rows[k][0] << 24) | (rows[k][1] << 16) | (rows[k][2] << 8) | rows[k][3];
+    }
+}
+
+// -- Both ways on one row of 24 strips, strip i in pixels[i]
+static void checkRow(const uint8_t * pixels)
+{
+    uint8_t row[32] __attribute__ ((aligned (4))) = {};
+    uint8_t reversed[24];
+    for (int i = 0; i < 24; i++) {
+        row[i] = pixels[i];
+        reversed[23 - i] = pixels[i];
+    }
+
+    uint32_t oldBits[8];
+    uint32_t newBits[8];
+    oldTranspose(reversed, oldBits);
+    transpose24(row, newBits);
+    CHECK(memcmp(oldBits, newBits, sizeof(newBits)) == 0);
+}
+
+#define NUM_ROWS 256
+
+int main()
+{
+    uint8_t pixels[24];
+
+    // -- Every single bit on its own, then random rows
+    for (int i = 0; i < 24; i++) {
+        for (int bit = 0; bit < 8; bit++) {
+            memset(pixels, 0, sizeof(pixels));
+            pixels[i] = 1 << bit;
+            checkRow(pixels);
+        }
+    }
+    for (int n = 0; n < 10000; n++) {
+        for (int i = 0; i < 24; i++) pixels[i] = random8();
+        checkRow(pixels);
+    }
+
+    // -- Time a buffer's worth of rows
+    static uint8_t rows[NUM_ROWS][32] __attribute__ ((aligned (4)));
+    static uint8_t reversed[NUM_ROWS][24];
+    static uint32_t bits[NUM_ROWS][8];
+    for (int r = 0; r < NUM_ROWS; r++) {
+        for (int i = 0; i < 24; i++) {
+            rows[r][i] = random8();
+            reversed[r][23 - i] = rows[r][i];
+        }
+    }
+
+    printf("transposing %d rows of 24 strips\n", NUM_ROWS);
+    double oldNs = timeNs([&]() { for (int r = 0; r < NUM_ROWS; r++) oldTranspose(reversed[r], bits[r]); }, 2000);
+    double newNs = timeNs([&]() { for (int r = 0; r < NUM_ROWS; r++) transpose24(rows[r], bits[r]); }, 2000);
+    report("transpose", oldNs, newNs);
+
+    return finish("bench_transpose");
+}
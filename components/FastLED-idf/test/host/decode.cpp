@@ -0,0 +1,62 @@
+#include "decode.h"
+
+const BitTiming WS2812_TIMING = { 250, 875, 1250, 150, 5000 };
+const BitTiming SK6812_TIMING = { 300, 600, 1200, 100, 5000 };
+
+static bool near(uint64_t ps, uint32_t ns, uint32_t toleranceNs)
+{
+    int64_t diff = (int64_t) ps - (int64_t) ns * 1000;
+    if (diff < 0) diff = -diff;
+    return diff <= (int64_t) toleranceNs * 1000;
+}
+
+std::vector<DecodedFrame> decodeFrames(const sim::Waveform & wave, const BitTiming & timing)
+{
+    std::vector<DecodedFrame> frames;
+    uint64_t threshold = (uint64_t) (timing.t0hNs + timing.t1hNs) * 500;
+    uint64_t resetPs = (uint64_t) timing.resetNs * 1000;
+
+    DecodedFrame frame;
+    uint32_t byteval = 0;
+    int bits = 0;
+    bool inFrame = false;
+
+    for (size_t i = 0; i < wave.size(); i++) {
+        if (wave[i].level == 0) continue;
+
+        if ( ! inFrame) {
+            frame = DecodedFrame();
+            frame.badPulses = 0;
+            frame.strayBits = 0;
+            byteval = 0;
+            bits = 0;
+            inFrame = true;
+        }
+
+        // -- The high part decides the bit, the low part ends it
+        uint64_t high = wave[i].ps;
+        bool last = (i + 2 >= wave.size()) || (wave[i + 1].ps > resetPs);
+        if ( ! near(high, timing.t0hNs, timing.toleranceNs) && ! near(high, timing.t1hNs, timing.toleranceNs)) {
+            frame.badPulses++;
+        }
+        if ( ! last && ! near(high + wave[i + 1].ps, timing.periodNs, timing.toleranceNs)) {
+            frame.badPulses++;
+        }
+
+        byteval = (byteval << 1) | ((high > threshold) ? 1 : 0);
+        bits++;
+        if (bits == 8) {
+            frame.bytes.push_back(byteval);
+            byteval = 0;
+            bits = 0;
+        }
+
+        if (last) {
+            frame.strayBits = bits;
+            frames.push_back(frame);
+            inFrame = false;
+        }
+    }
+
+    return frames;
+}
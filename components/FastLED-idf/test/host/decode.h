@@ -0,0 +1,37 @@
+#pragma once
+
+// -- Decode a captured clockless waveform back into bytes
+//    Independent of the drivers: a high pulse closer to T1H than to
+//    T0H is a one, MSB first, and a low longer than resetNs ends a
+//    frame.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "sim.h"
+
+struct BitTiming {
+    uint32_t t0hNs;
+    uint32_t t1hNs;
+    uint32_t periodNs;
+    uint32_t toleranceNs;
+    uint32_t resetNs;
+};
+
+// -- WS2812: 250ns/875ns high in a 1250ns bit
+extern const BitTiming WS2812_TIMING;
+
+// -- SK6812: 300ns/600ns high in a 1200ns bit
+extern const BitTiming SK6812_TIMING;
+
+struct DecodedFrame {
+    std::vector<uint8_t> bytes;
+
+    // -- Pulses whose high time or period is out of tolerance, and
+    //    bits left over after the last whole byte
+    int badPulses;
+    int strayBits;
+};
+
+std::vector<DecodedFrame> decodeFrames(const sim::Waveform & wave, const BitTiming & timing);
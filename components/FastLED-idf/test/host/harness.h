@@ -0,0 +1,140 @@
+#pragma once
+
+// -- Shared pieces of the round-trip tests
+//    Each strip is a real controller wrapped in a Tap, which works out
+//    what the strip should receive from the PixelController the driver
+//    is given. The simulated hardware records what the driver actually
+//    sent, and the decoder turns that back into bytes to compare.
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include "FastLED.h"
+#include "sim.h"
+#include "decode.h"
+
+static int gFailures = 0;
+
+#define CHECK(cond) do {                                                        \
+        if ( ! (cond)) {                                                        \
+            gFailures++;                                                        \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+        }                                                                       \
+    } while(0)
+
+// -- What a Tap saw, one entry per showPixels() call
+struct TapLog {
+    std::vector<std::vector<uint8_t> > sent;
+};
+
+template <typename BASE, EOrder RGB_ORDER, EWhiteMode WHITE = RGBW_NONE>
+class Tap : public BASE, public TapLog {
+protected:
+    virtual void showPixels(PixelController<RGB_ORDER> & pixels)
+    {
+        // -- Scale and dither a copy with the generic loaders. The
+        //    temporal dither error is put back, so the driver starts
+        //    from the same state.
+        PixelController<RGB_ORDER> copy(pixels);
+#if FASTLED_TEMPORAL_DITHER
+        std::vector<uint8_t> err;
+        if (copy.mErr) err.assign(copy.mErr, copy.mErr + 3 * copy.mLen);
+#endif
+        std::vector<uint8_t> bytes;
+        while (copy.has(1)) {
+            if (WHITE != RGBW_NONE) {
+                uint8_t b0, b1, b2;
+                uint8_t w = copy.template loadAndScaleRGBW<WHITE>(b0, b1, b2);
+                bytes.push_back(b0);
+                bytes.push_back(b1);
+                bytes.push_back(b2);
+                bytes.push_back(w);
+            } else {
+                bytes.push_back(copy.loadAndScale0());
+                bytes.push_back(copy.loadAndScale1());
+                bytes.push_back(copy.loadAndScale2());
+            }
+            copy.advanceData();
+            copy.stepDithering();
+        }
+#if FASTLED_TEMPORAL_DITHER
+        if (copy.mErr) memcpy(copy.mErr, err.data(), err.size());
+#endif
+        sent.push_back(bytes);
+
+        BASE::showPixels(pixels);
+    }
+};
+
+struct Strip {
+    CLEDController * controller;
+    TapLog * log;
+    int pin;
+    const BitTiming * timing;
+    CRGB * leds;
+    int numLeds;
+};
+
+// -- Fill with something new every frame
+static inline void fillRandom(CRGB * leds, int n)
+{
+    for (int i = 0; i < n; i++) {
+        leds[i] = CRGB(random8(), random8(), random8());
+    }
+}
+
+// -- The bytes of unscaled, undithered RGB pixels in wire order
+static inline std::vector<uint8_t> rawBytes(const CRGB * leds, int n, EOrder order)
+{
+    std::vector<uint8_t> bytes;
+    for (int i = 0; i < n; i++) {
+        bytes.push_back(leds[i].raw[(order >> 6) & 3]);
+        bytes.push_back(leds[i].raw[(order >> 3) & 3]);
+        bytes.push_back(leds[i].raw[order & 3]);
+    }
+    return bytes;
+}
+
+// -- Check what went out on the strip's pin since the waveforms were
+//    cleared, and forget it
+//    A strip that was shown must have sent exactly one good frame (or
+//    retries, then one good frame): the Tap's bytes, then up to
+//    padTo - 1 zero bytes. A strip that was not shown must be silent.
+static inline void checkStrip(Strip & strip, int padTo, bool allowRetries = false)
+{
+    std::vector<DecodedFrame> frames = decodeFrames(sim::waveform(strip.pin), *strip.timing);
+
+    if (strip.log->sent.empty()) {
+        CHECK(frames.empty());
+        return;
+    }
+
+    CHECK(strip.log->sent.size() == 1);
+    CHECK(frames.size() >= 1);
+    if ( ! allowRetries) CHECK(frames.size() == 1);
+    if (frames.empty()) return;
+
+    const DecodedFrame & frame = frames.back();
+    std::vector<uint8_t> expected = strip.log->sent.back();
+    while (expected.size() % padTo) expected.push_back(0);
+
+    CHECK(frame.badPulses == 0);
+    CHECK(frame.strayBits == 0);
+    CHECK(frame.bytes == expected);
+    if (frame.bytes != expected) {
+        fprintf(stderr, "  pin %d: got %d bytes, expected %d\n", strip.pin, (int) frame.bytes.size(), (int) expected.size());
+    }
+
+    strip.log->sent.clear();
+}
+
+static inline int finish(const char * name)
+{
+    if (gFailures) {
+        fprintf(stderr, "%s: %d checks failed\n", name, gFailures);
+        return 1;
+    }
+    printf("%s: ok\n", name);
+    return 0;
+}
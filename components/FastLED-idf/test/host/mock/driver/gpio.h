@@ -0,0 +1,25 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum { GPIO_NUM_0 = 0, GPIO_NUM_MAX = 40 } gpio_num_t;
+typedef enum { GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+
+#define GPIO_MODE_DEF_OUTPUT    2
+#define PIN_FUNC_GPIO           2
+#define PIN_FUNC_SELECT(reg, func) (void)(reg)
+
+extern const uint32_t GPIO_PIN_MUX_REG[GPIO_NUM_MAX];
+
+esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode);
+void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PERIPH_I2S0_MODULE,
+    PERIPH_I2S1_MODULE,
+    PERIPH_RMT_MODULE,
+    PERIPH_HSPI_MODULE,
+    PERIPH_VSPI_MODULE
+} periph_module_t;
+
+void periph_module_enable(periph_module_t periph);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,64 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "driver/gpio.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum { RMT_CHANNEL_0 = 0, RMT_CHANNEL_MAX = 8 } rmt_channel_t;
+typedef enum { RMT_MODE_TX = 0 } rmt_mode_t;
+typedef enum { RMT_CARRIER_LEVEL_LOW = 0 } rmt_carrier_level_t;
+typedef enum { RMT_IDLE_LEVEL_LOW = 0 } rmt_idle_level_t;
+
+typedef struct {
+    union {
+        struct {
+            uint32_t duration0 :15;
+            uint32_t level0 :1;
+            uint32_t duration1 :15;
+            uint32_t level1 :1;
+        };
+        uint32_t val;
+    };
+} rmt_item32_t;
+
+typedef struct {
+    bool loop_en;
+    rmt_carrier_level_t carrier_level;
+    bool carrier_en;
+    rmt_idle_level_t idle_level;
+    bool idle_output_en;
+} rmt_tx_config_t;
+
+typedef struct {
+    rmt_mode_t rmt_mode;
+    rmt_channel_t channel;
+    gpio_num_t gpio_num;
+    uint8_t clk_div;
+    uint8_t mem_block_num;
+    rmt_tx_config_t tx_config;
+} rmt_config_t;
+
+#define RMT_DEFAULT_CONFIG_TX(gpio, channel_id) { RMT_MODE_TX, channel_id, gpio, 80, 1, { false, RMT_CARRIER_LEVEL_LOW, false, RMT_IDLE_LEVEL_LOW, true } }
+
+typedef void (*rmt_tx_end_fn_t)(rmt_channel_t channel, void * arg);
+
+esp_err_t rmt_config(const rmt_config_t * config);
+esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags);
+esp_err_t rmt_set_tx_thr_intr_en(rmt_channel_t channel, bool en, uint16_t evt_thresh);
+esp_err_t rmt_set_tx_intr_en(rmt_channel_t channel, bool en);
+esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst);
+esp_err_t rmt_tx_stop(rmt_channel_t channel);
+esp_err_t rmt_set_pin(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num);
+esp_err_t rmt_set_mem_block_num(rmt_channel_t channel, uint8_t rmt_mem_num);
+void * rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void * arg);
+esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t * rmt_item, int item_num, bool wait_tx_done);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,17 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+typedef enum { SPI1_HOST=0, SPI2_HOST=1, SPI3_HOST=2 } spi_host_device_t;
+#define HSPI_HOST SPI2_HOST
+#define VSPI_HOST SPI3_HOST
+typedef struct { int mosi_io_num, miso_io_num, sclk_io_num, quadwp_io_num, quadhd_io_num, max_transfer_sz; uint32_t flags; int intr_flags; } spi_bus_config_t;
+typedef struct { uint8_t command_bits, address_bits, dummy_bits, mode; uint16_t duty_cycle_pos, cs_ena_pretrans; uint8_t cs_ena_posttrans; int clock_speed_hz, input_delay_ns, spics_io_num; uint32_t flags; int queue_size; void* pre_cb; void* post_cb; } spi_device_interface_config_t;
+typedef struct { uint32_t flags; uint16_t cmd; uint64_t addr; size_t length, rxlength; void* user; const void* tx_buffer; void* rx_buffer; } spi_transaction_t;
+typedef struct spi_device_t* spi_device_handle_t;
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t*, int);
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t*, spi_device_handle_t*);
+esp_err_t spi_device_queue_trans(spi_device_handle_t, spi_transaction_t*, TickType_t);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t, spi_transaction_t**, TickType_t);
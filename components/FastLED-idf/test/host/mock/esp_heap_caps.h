@@ -0,0 +1,20 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stddef.h>
+#include <stdint.h>
+
+#define MALLOC_CAP_32BIT        (1<<1)
+#define MALLOC_CAP_8BIT         (1<<2)
+#define MALLOC_CAP_DMA          (1<<3)
+#define MALLOC_CAP_SPIRAM       (1<<10)
+#define MALLOC_CAP_INTERNAL     (1<<11)
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void * heap_caps_malloc(size_t size, uint32_t caps);
+void * heap_caps_calloc(size_t n, size_t size, uint32_t caps);
+void heap_caps_free(void * ptr);
+#ifdef __cplusplus
+}
+#endif
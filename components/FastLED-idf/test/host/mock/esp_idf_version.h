@@ -0,0 +1,4 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#define ESP_IDF_VERSION_VAL(a,b,c) (((a)<<16)|((b)<<8)|(c))
+#define ESP_IDF_VERSION ESP_IDF_VERSION_VAL(4,2,0)
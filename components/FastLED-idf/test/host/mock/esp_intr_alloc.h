@@ -0,0 +1,28 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include "esp_err.h"
+
+#define ESP_INTR_FLAG_LEVEL2    (1<<2)
+#define ESP_INTR_FLAG_LEVEL3    (1<<3)
+#define ESP_INTR_FLAG_IRAM      (1<<10)
+
+#define ETS_SPI2_INTR_SOURCE    30
+#define ETS_I2S0_INTR_SOURCE    32
+#define ETS_I2S1_INTR_SOURCE    33
+#define ETS_RMT_INTR_SOURCE     47
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct intr_handle_data_t * intr_handle_t;
+typedef void (*intr_handler_t)(void * arg);
+
+esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void * arg, intr_handle_t * ret_handle);
+esp_err_t esp_intr_enable(intr_handle_t handle);
+esp_err_t esp_intr_disable(intr_handle_t handle);
+esp_err_t esp_intr_free(intr_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,16 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+// Messages go to stderr, and the simulator counts the errors (see sim.h).
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+void sim_log(char level, const char * tag, const char * format, ...) __attribute__ ((format (printf, 3, 4)));
+#ifdef __cplusplus
+}
+#endif
+
+#define ESP_LOGE(tag, format, ...) sim_log('E', tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...) sim_log('W', tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...) sim_log('I', tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...) do { } while(0)
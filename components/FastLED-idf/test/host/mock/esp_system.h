@@ -0,0 +1,8 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#define IRAM_ATTR
+#define DRAM_ATTR
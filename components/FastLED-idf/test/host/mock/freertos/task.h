@@ -0,0 +1,21 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include "FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void * TaskHandle_t;
+
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t * previous, TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+void vPortYield(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define taskYIELD() vPortYield()
@@ -0,0 +1,4 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#define CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ 240
+#define CONFIG_ESP32_PHY_AUTO_INIT 1
@@ -0,0 +1,10 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+typedef struct { volatile uint32_t val; } gpio_reg_t;
+typedef struct {
+  volatile uint32_t out; volatile uint32_t out_w1ts; volatile uint32_t out_w1tc;
+  gpio_reg_t out1, out1_w1ts, out1_w1tc;
+  volatile uint32_t in; gpio_reg_t in1;
+} gpio_dev_t;
+extern gpio_dev_t GPIO;
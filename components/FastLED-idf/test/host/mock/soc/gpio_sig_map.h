@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#define I2S0O_DATA_OUT0_IDX 140
+#define I2S1O_DATA_OUT0_IDX 166
+#define I2S0O_BCK_OUT_IDX 13
+#define I2S1O_BCK_OUT_IDX 15
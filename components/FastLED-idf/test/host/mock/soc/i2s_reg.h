@@ -0,0 +1,17 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#define I2S_INT_ENA_REG(i) (0x3ff4f000 + (i))
+#define I2S_OUT_EOF_INT_ENA_V 1
+#define I2S_OUT_EOF_INT_ENA_S 12
+#define I2S_OUT_DATA_BURST_EN (1<<12)
+#define I2S_OUTDSCR_BURST_EN (1<<10)
+#define I2S_IN_RST_M (1<<0)
+#define I2S_OUT_RST_M (1<<1)
+#define I2S_AHBM_RST_M (1<<2)
+#define I2S_AHBM_FIFO_RST_M (1<<3)
+#define I2S_RX_RESET_M (1<<1)
+#define I2S_RX_FIFO_RESET_M (1<<3)
+#define I2S_TX_RESET_M (1<<0)
+#define I2S_TX_FIFO_RESET_M (1<<2)
+#define I2S_OUT_AUTO_WRBACK (1<<11)
+#define I2S_OUT_EOF_MODE (1<<9)
@@ -0,0 +1,133 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+// Only the registers the drivers use; the simulator reads them back.
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef volatile struct {
+    union {
+        struct {
+            uint32_t tx_reset :1;
+            uint32_t rx_reset :1;
+            uint32_t tx_fifo_reset :1;
+            uint32_t rx_fifo_reset :1;
+            uint32_t tx_start :1;
+            uint32_t rx_start :1;
+            uint32_t tx_slave_mod :1;
+            uint32_t rx_slave_mod :1;
+            uint32_t tx_right_first :1;
+            uint32_t rx_right_first :1;
+            uint32_t tx_msb_shift :1;
+            uint32_t rx_msb_shift :1;
+            uint32_t tx_short_sync :1;
+            uint32_t rx_short_sync :1;
+            uint32_t tx_mono :1;
+            uint32_t rx_mono :1;
+            uint32_t tx_msb_right :1;
+            uint32_t rx_msb_right :1;
+        };
+        uint32_t val;
+    } conf;
+    union {
+        struct {
+            uint32_t in_rst :1;
+            uint32_t out_rst :1;
+            uint32_t ahbm_fifo_rst :1;
+            uint32_t ahbm_rst :1;
+            uint32_t out_loop_test :1;
+            uint32_t in_loop_test :1;
+            uint32_t out_auto_wrback :1;
+            uint32_t out_no_restart_clr :1;
+            uint32_t out_eof_mode :1;
+            uint32_t outdscr_burst_en :1;
+            uint32_t indscr_burst_en :1;
+            uint32_t out_data_burst_en :1;
+        };
+        uint32_t val;
+    } lc_conf;
+    union {
+        struct {
+            uint32_t addr :20;
+            uint32_t reserved :8;
+            uint32_t stop :1;
+            uint32_t start :1;
+            uint32_t restart :1;
+            uint32_t park :1;
+        };
+        uint32_t val;
+    } out_link;
+    union {
+        struct {
+            uint32_t out_done :1;
+            uint32_t out_eof :1;
+            uint32_t out_dscr_err :1;
+            uint32_t out_total_eof :1;
+        };
+        uint32_t val;
+    } int_raw, int_st, int_ena, int_clr;
+    union {
+        struct {
+            uint32_t lcd_tx_wrx2_en :1;
+            uint32_t lcd_tx_sdx2_en :1;
+            uint32_t lcd_en :1;
+        };
+        uint32_t val;
+    } conf2;
+    union {
+        struct {
+            uint32_t tx_bits_mod :6;
+            uint32_t tx_bck_div_num :6;
+        };
+        uint32_t val;
+    } sample_rate_conf;
+    union {
+        struct {
+            uint32_t clkm_div_num :8;
+            uint32_t clkm_div_b :6;
+            uint32_t clkm_div_a :6;
+            uint32_t clk_en :1;
+            uint32_t clka_en :1;
+        };
+        uint32_t val;
+    } clkm_conf;
+    union {
+        struct {
+            uint32_t tx_data_num :6;
+            uint32_t dscr_en :1;
+            uint32_t tx_fifo_mod :3;
+            uint32_t tx_fifo_mod_force_en :1;
+        };
+        uint32_t val;
+    } fifo_conf;
+    union {
+        struct {
+            uint32_t tx_stop_en :1;
+            uint32_t tx_pcm_bypass :1;
+        };
+        uint32_t val;
+    } conf1;
+    union {
+        struct {
+            uint32_t tx_chan_mod :3;
+        };
+        uint32_t val;
+    } conf_chan;
+    union { uint32_t val; } timing;
+    uint32_t out_eof_des_addr;
+    union {
+        struct {
+            uint32_t tx_idle :1;
+        };
+        uint32_t val;
+    } state;
+} i2s_dev_t;
+
+extern i2s_dev_t I2S0;
+extern i2s_dev_t I2S1;
+
+#ifdef __cplusplus
+}
+#endif
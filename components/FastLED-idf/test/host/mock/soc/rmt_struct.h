@@ -0,0 +1,64 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+// The simulator plays out what the driver writes into RMTMEM.
+#include <stdint.h>
+#include "soc/soc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef volatile struct {
+    struct {
+        union {
+            struct {
+                uint32_t div_cnt :8;
+                uint32_t idle_thres :16;
+                uint32_t mem_size :4;
+                uint32_t carrier_en :1;
+                uint32_t carrier_out_lv :1;
+                uint32_t mem_pd :1;
+                uint32_t clk_en :1;
+            };
+            uint32_t val;
+        } conf0;
+        union {
+            struct {
+                uint32_t tx_start :1;
+                uint32_t rx_en :1;
+                uint32_t mem_wr_rst :1;
+                uint32_t mem_rd_rst :1;
+                uint32_t apb_mem_rst :1;
+                uint32_t mem_owner :1;
+                uint32_t tx_conti_mode :1;
+                uint32_t rx_filter_en :1;
+                uint32_t rx_filter_thres :8;
+                uint32_t ref_cnt_rst :1;
+                uint32_t ref_always_on :1;
+                uint32_t idle_out_lv :1;
+                uint32_t idle_out_en :1;
+            };
+            uint32_t val;
+        } conf1;
+    } conf_ch[8];
+    union { uint32_t val; } int_raw;
+    union { uint32_t val; } int_st;
+    union { uint32_t val; } int_ena;
+    union { uint32_t val; } int_clr;
+} rmt_dev_t;
+
+extern rmt_dev_t RMT;
+
+typedef struct {
+    struct {
+        union {
+            uint32_t val;
+        } data32[64];
+    } chan[8];
+} rmt_mem_t;
+
+extern volatile rmt_mem_t RMTMEM;
+
+#ifdef __cplusplus
+}
+#endif
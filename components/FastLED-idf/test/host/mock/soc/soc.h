@@ -0,0 +1,6 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+#include <stdint.h>
+
+#define BIT(nr) (1UL << (nr))
+#define SET_PERI_REG_BITS(reg, bit_map, value, shift) (void)(reg)
@@ -0,0 +1,11 @@
+#pragma once
+// Host stand-in for the ESP-IDF header of the same name
+// The CPU cycle counter, at CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ of simulated time
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+unsigned xthal_get_ccount(void);
+#ifdef __cplusplus
+}
+#endif
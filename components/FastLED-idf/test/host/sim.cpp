@@ -0,0 +1,711 @@
+// -- Host simulation of the ESP32 peripherals used by the LED drivers
+//    Implements the mock ESP-IDF headers in mock/ (see sim.h).
+
+#include "sim.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <deque>
+#include <map>
+
+#include "esp_err.h"
+#include "esp_log.h"
+#include "esp_heap_caps.h"
+#include "esp_intr_alloc.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/gpio.h"
+#include "driver/periph_ctrl.h"
+#include "driver/rmt.h"
+#include "soc/gpio_periph.h"
+#include "soc/gpio_sig_map.h"
+#include "soc/rmt_struct.h"
+#include "soc/i2s_struct.h"
+#include "esp32/rom/lldesc.h"
+#include "xtensa/hal.h"
+#include "sdkconfig.h"
+
+// -- The memory-mapped peripherals
+rmt_dev_t RMT;
+volatile rmt_mem_t RMTMEM;
+i2s_dev_t I2S0;
+i2s_dev_t I2S1;
+gpio_dev_t GPIO;
+const uint32_t GPIO_PIN_MUX_REG[GPIO_NUM_MAX] = { 0 };
+
+struct sim_semaphore {
+    int count;
+    int max;
+};
+
+struct esp_timer {
+    esp_timer_cb_t callback;
+    void * arg;
+    bool armed;
+    uint64_t due;
+};
+
+struct intr_handle_data_t {
+    int source;
+    intr_handler_t handler;
+    void * arg;
+    bool enabled;
+};
+
+namespace {
+
+const uint64_t PS_PER_US = 1000000;
+const uint64_t PS_PER_TICK = 1000000000ULL * portTICK_PERIOD_MS;
+const uint64_t NEVER = ~0ULL;
+
+// -- RMT clock after DIVIDER 2: 25ns
+const uint64_t RMT_TICK_PS = 25000;
+
+const int RMT_SIGNAL = 1000;
+const int I2S_SIGNAL = 2000;
+
+uint64_t gNow = 0;
+int gIsrDepth = 0;
+int gErrors = 0;
+
+// -- Which signal drives each pin
+std::map<int, int> gPinSignal;
+
+struct Pin {
+    sim::Waveform wave;
+    uint64_t end;
+};
+std::map<int, Pin> gPins;
+sim::Waveform gNoWave;
+
+// -- Interrupts raised by the hardware, delivered in order
+struct Irq {
+    uint64_t at;
+    int source;
+    uint32_t bits;
+};
+std::deque<Irq> gIrqs;
+std::vector<intr_handle_data_t *> gHandlers;
+uint64_t gRmtIsrDelayPs = 0;
+uint64_t gRmtBlockedUntil = 0;
+
+std::vector<esp_timer *> gTimers;
+int gFailTimerCreate = 0;
+int gTimersCreated = 0;
+
+// -- DMA capable memory: a 1MB region, so that the 20 bits of a
+//    descriptor address in out_link are enough to find it. Freed
+//    blocks are not reused.
+const size_t DMA_REGION = 1 << 20;
+uint8_t * gDmaBase = 0;
+size_t gDmaUsed = 0;
+int gFailDmaAlloc = 0;
+
+struct RmtChannel {
+    int blocks = 1;
+    uint32_t thr = 0;
+    bool thrEn = false;
+    bool endEn = false;
+    bool running = false;
+    bool pendingThr = false;
+    bool endNext = false;
+    uint32_t idx = 0;
+    uint32_t sent = 0;
+    uint64_t next = 0;
+};
+RmtChannel gRmt[8];
+
+struct I2sState {
+    i2s_dev_t * dev;
+    int source;
+    bool running;
+    lldesc_t * rd;
+    uint32_t rdPos;
+    std::deque<uint32_t> fifo;
+    uint64_t next;
+};
+I2sState gI2s[2] = {
+    { &I2S0, ETS_I2S0_INTR_SOURCE, false, 0, 0, {}, 0 },
+    { &I2S1, ETS_I2S1_INTR_SOURCE, false, 0, 0, {}, 0 }
+};
+size_t gFifoWords = 64;
+
+// -- Record level for ps on every pin driven by signal
+void emit(int signal, uint8_t level, uint64_t ps, uint64_t at)
+{
+    for (std::map<int, int>::iterator it = gPinSignal.begin(); it != gPinSignal.end(); ++it) {
+        if (it->second != signal) continue;
+        Pin & pin = gPins[it->first];
+        sim::Waveform & w = pin.wave;
+        if ( ! w.empty() && at > pin.end) {
+            if (w.back().level == 0) w.back().ps += at - pin.end;
+            else w.push_back(sim::Segment{ 0, at - pin.end });
+        }
+        if ( ! w.empty() && w.back().level == level) w.back().ps += ps;
+        else w.push_back(sim::Segment{ level, ps });
+        pin.end = at + ps;
+    }
+}
+
+void raise(int source, uint32_t bits)
+{
+    // -- A delayed RMT interrupt holds up the ones after it too
+    uint64_t at = gNow;
+    if (source == ETS_RMT_INTR_SOURCE) {
+        if (gRmtIsrDelayPs) {
+            gRmtBlockedUntil = gNow + gRmtIsrDelayPs;
+            gRmtIsrDelayPs = 0;
+        }
+        if (gRmtBlockedUntil > at) at = gRmtBlockedUntil;
+    }
+
+    std::deque<Irq>::iterator it = gIrqs.end();
+    while (it != gIrqs.begin() && (it - 1)->at > at) --it;
+    gIrqs.insert(it, Irq{ at, source, bits });
+}
+
+void dispatch(const Irq & irq)
+{
+    volatile uint32_t * raw;
+    volatile uint32_t * st;
+    uint32_t ena;
+    if (irq.source == ETS_RMT_INTR_SOURCE) {
+        raw = &RMT.int_raw.val;
+        st = &RMT.int_st.val;
+        ena = ~0u;
+    } else {
+        i2s_dev_t * dev = (irq.source == ETS_I2S0_INTR_SOURCE) ? &I2S0 : &I2S1;
+        raw = &dev->int_raw.val;
+        st = &dev->int_st.val;
+        ena = dev->int_ena.val;
+    }
+
+    // -- Masked interrupts are raised but not taken
+    if (irq.bits & ena) {
+        *raw |= irq.bits;
+        *st |= irq.bits & ena;
+        gIsrDepth++;
+        for (size_t i = 0; i < gHandlers.size(); i++) {
+            intr_handle_data_t * h = gHandlers[i];
+            if (h->source == irq.source && h->enabled) h->handler(h->arg);
+        }
+        gIsrDepth--;
+    }
+    *raw &= ~irq.bits;
+    *st &= ~irq.bits;
+}
+
+// -- RMT
+void rmtEnd(int ch)
+{
+    RmtChannel & c = gRmt[ch];
+    c.running = false;
+    if (c.endEn) {
+        raise(ETS_RMT_INTR_SOURCE, 1u << (ch * 3));
+    }
+}
+
+void rmtStep(int ch)
+{
+    RmtChannel & c = gRmt[ch];
+    if (c.pendingThr) {
+        c.pendingThr = false;
+        raise(ETS_RMT_INTR_SOURCE, 1u << (ch + 24));
+    }
+    if (c.endNext) {
+        c.endNext = false;
+        rmtEnd(ch);
+        return;
+    }
+
+    // -- A channel with several blocks uses the memory of the
+    //    channels after it
+    const volatile uint32_t * mem = &RMTMEM.chan[0].data32[0].val;
+    rmt_item32_t item;
+    item.val = mem[(ch * 64 + (c.idx % (c.blocks * 64))) % (8 * 64)];
+
+    if (item.duration0 == 0) {
+        rmtEnd(ch);
+        return;
+    }
+
+    emit(RMT_SIGNAL + ch, item.level0, item.duration0 * RMT_TICK_PS, c.next);
+    c.next += item.duration0 * RMT_TICK_PS;
+    if (item.duration1 == 0) {
+        c.endNext = true;
+        return;
+    }
+    emit(RMT_SIGNAL + ch, item.level1, item.duration1 * RMT_TICK_PS, c.next);
+    c.next += item.duration1 * RMT_TICK_PS;
+
+    c.idx++;
+    c.sent++;
+    if (c.thrEn && c.thr && (c.sent % c.thr) == 0) {
+        c.pendingThr = true;
+    }
+}
+
+// -- I2S
+lldesc_t * findDescriptor(uint32_t addr)
+{
+    if (gDmaBase == 0 || addr + sizeof(lldesc_t) > gDmaUsed) {
+        fprintf(stderr, "sim: I2S descriptor address 0x%05x is not in DMA memory\n", addr);
+        abort();
+    }
+    return (lldesc_t *) (gDmaBase + addr);
+}
+
+uint64_t i2sWordPs(const i2s_dev_t * dev)
+{
+    uint64_t n = dev->clkm_conf.clkm_div_num;
+    uint64_t a = dev->clkm_conf.clkm_div_a;
+    uint64_t b = dev->clkm_conf.clkm_div_b;
+    if (a == 0) return 12500 * n;
+    return (12500 * (n * a + b)) / a;
+}
+
+void i2sStop(I2sState & s)
+{
+    s.running = false;
+    s.fifo.clear();
+    s.rd = 0;
+    s.dev->state.tx_idle = 1;
+}
+
+void i2sStep(int d)
+{
+    I2sState & s = gI2s[d];
+    i2s_dev_t * dev = s.dev;
+
+    if (dev->out_link.start) {
+        dev->out_link.start = 0;
+        i2sStop(s);
+        s.rd = findDescriptor(dev->out_link.addr);
+        s.rdPos = 0;
+        s.running = true;
+        s.next = gNow;
+        dev->state.tx_idle = 0;
+    }
+    if ( ! dev->conf.tx_start) {
+        i2sStop(s);
+        return;
+    }
+
+    // -- The DMA keeps the FIFO full; a buffer's EOF is raised as soon
+    //    as its last word is in the FIFO
+    while (s.fifo.size() < gFifoWords && s.rd) {
+        const uint32_t * words = (const uint32_t *) s.rd->buf;
+        s.fifo.push_back(words[s.rdPos / 4]);
+        s.rdPos += 4;
+        if (s.rdPos >= s.rd->length) {
+            bool eof = s.rd->eof;
+            s.rd = s.rd->qe.stqe_next;
+            s.rdPos = 0;
+            if (eof) raise(s.source, 1u << 1);
+        }
+    }
+    if (s.fifo.empty()) {
+        i2sStop(s);
+        return;
+    }
+
+    uint32_t word = s.fifo.front();
+    s.fifo.pop_front();
+    uint64_t ps = i2sWordPs(dev);
+    for (int lane = 0; lane < 24; lane++) {
+        emit(I2S_SIGNAL + d * 100 + lane, (word >> (lane + 8)) & 1, ps, s.next);
+    }
+    s.next += ps;
+}
+
+bool i2sStartable(const I2sState & s)
+{
+    return s.dev->out_link.start && s.dev->conf.tx_start;
+}
+
+// -- Run the next hardware event, if it is due by limit
+bool step(uint64_t limit)
+{
+    uint64_t best = NEVER;
+    int kind = -1, which = -1;
+
+    if ( ! gIrqs.empty()) {
+        best = gIrqs.front().at;
+        kind = 0;
+    }
+    for (size_t i = 0; i < gTimers.size(); i++) {
+        if (gTimers[i]->armed && gTimers[i]->due < best) {
+            best = gTimers[i]->due;
+            kind = 1;
+            which = i;
+        }
+    }
+    for (int ch = 0; ch < 8; ch++) {
+        if (gRmt[ch].running && gRmt[ch].next < best) {
+            best = gRmt[ch].next;
+            kind = 2;
+            which = ch;
+        }
+    }
+    for (int d = 0; d < 2; d++) {
+        uint64_t at = gI2s[d].running ? gI2s[d].next : (i2sStartable(gI2s[d]) ? gNow : NEVER);
+        if (at < best) {
+            best = at;
+            kind = 3;
+            which = d;
+        }
+    }
+
+    if (kind < 0 || best > limit) return false;
+    if (best > gNow) gNow = best;
+
+    switch (kind) {
+    case 0: {
+        Irq irq = gIrqs.front();
+        gIrqs.pop_front();
+        dispatch(irq);
+        break;
+    }
+    case 1: {
+        esp_timer * t = gTimers[which];
+        t->armed = false;
+        t->callback(t->arg);
+        break;
+    }
+    case 2:
+        rmtStep(which);
+        break;
+    case 3:
+        i2sStep(which);
+        break;
+    }
+    return true;
+}
+
+void advanceTo(uint64_t t)
+{
+    if (gIsrDepth == 0) {
+        while (step(t)) { }
+    }
+    if (t > gNow) gNow = t;
+}
+
+} // namespace
+
+namespace sim {
+
+uint64_t now() { return gNow; }
+
+void run(uint64_t ns) { advanceTo(gNow + ns * 1000); }
+
+bool idle()
+{
+    if ( ! gIrqs.empty()) return false;
+    for (int ch = 0; ch < 8; ch++) {
+        if (gRmt[ch].running) return false;
+    }
+    for (int d = 0; d < 2; d++) {
+        if (gI2s[d].running || i2sStartable(gI2s[d])) return false;
+    }
+    return true;
+}
+
+void runUntilIdle()
+{
+    while ( ! idle() && step(NEVER)) { }
+}
+
+const Waveform & waveform(int pin)
+{
+    std::map<int, Pin>::iterator it = gPins.find(pin);
+    return (it == gPins.end()) ? gNoWave : it->second.wave;
+}
+
+void clearWaveforms() { gPins.clear(); }
+
+int takeErrors()
+{
+    int n = gErrors;
+    gErrors = 0;
+    return n;
+}
+
+void delayNextRmtIsr(uint32_t ns) { gRmtIsrDelayPs = (uint64_t) ns * 1000; }
+void setI2sFifoWords(int words) { gFifoWords = (words < 1) ? 1 : words; }
+void failTimerCreate(int n) { gFailTimerCreate = n; }
+int timersCreated() { return gTimersCreated; }
+void failDmaAlloc(int n) { gFailDmaAlloc = n; }
+
+} // namespace sim
+
+// -- Logging
+extern "C" void sim_log(char level, const char * tag, const char * format, ...)
+{
+    if (level == 'E') gErrors++;
+    fprintf(stderr, "%c (%s) ", level, tag);
+    va_list args;
+    va_start(args, format);
+    vfprintf(stderr, format, args);
+    va_end(args);
+    fputc('\n', stderr);
+}
+
+// -- Time
+extern "C" unsigned xthal_get_ccount(void)
+{
+    return (unsigned) ((gNow * CONFIG_ESP32_DEFAULT_CPU_FREQ_MHZ) / PS_PER_US);
+}
+
+extern "C" int64_t esp_timer_get_time(void)
+{
+    advanceTo(gNow + PS_PER_US);
+    return gNow / PS_PER_US;
+}
+
+extern "C" unsigned long micros(void)
+{
+    advanceTo(gNow + PS_PER_US);
+    return gNow / PS_PER_US;
+}
+
+extern "C" unsigned long millis(void)
+{
+    advanceTo(gNow + PS_PER_US);
+    return gNow / (1000 * PS_PER_US);
+}
+
+extern "C" void delay(uint32_t ms) { advanceTo(gNow + ms * 1000 * PS_PER_US); }
+extern "C" void delayMicroseconds(uint32_t us) { advanceTo(gNow + us * PS_PER_US); }
+extern "C" void yield(void) { advanceTo(gNow + PS_PER_US); }
+extern "C" void vPortYield(void) { advanceTo(gNow + PS_PER_US); }
+
+extern "C" void vTaskDelay(TickType_t ticks) { advanceTo(gNow + ticks * PS_PER_TICK); }
+
+extern "C" void vTaskDelayUntil(TickType_t * previous, TickType_t ticks)
+{
+    *previous += ticks;
+    advanceTo((uint64_t) *previous * PS_PER_TICK);
+}
+
+extern "C" TickType_t xTaskGetTickCount(void) { return gNow / PS_PER_TICK; }
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void) { return (TaskHandle_t) &gNow; }
+
+// -- Timers
+extern "C" esp_err_t esp_timer_create(const esp_timer_create_args_t * args, esp_timer_handle_t * out_handle)
+{
+    gTimersCreated++;
+    if (gFailTimerCreate > 0) {
+        gFailTimerCreate--;
+        return ESP_ERR_NO_MEM;
+    }
+    esp_timer * t = new esp_timer();
+    t->callback = args->callback;
+    t->arg = args->arg;
+    t->armed = false;
+    gTimers.push_back(t);
+    *out_handle = t;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    if (timer == NULL) return ESP_ERR_INVALID_ARG;
+    if (timer->armed) return ESP_ERR_INVALID_STATE;
+    timer->armed = true;
+    timer->due = gNow + timeout_us * PS_PER_US;
+    return ESP_OK;
+}
+
+// -- Semaphores
+static SemaphoreHandle_t newSemaphore(int count)
+{
+    SemaphoreHandle_t s = new sim_semaphore();
+    s->count = count;
+    s->max = 1;
+    return s;
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateBinary(void) { return newSemaphore(0); }
+extern "C" SemaphoreHandle_t xSemaphoreCreateMutex(void) { return newSemaphore(1); }
+extern "C" void vSemaphoreDelete(SemaphoreHandle_t sem) { delete sem; }
+
+extern "C" BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max) return pdFALSE;
+    sem->count++;
+    return pdTRUE;
+}
+
+extern "C" BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t * woken)
+{
+    if (woken) *woken = pdFALSE;
+    return xSemaphoreGive(sem);
+}
+
+extern "C" BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    uint64_t deadline = (ticks == portMAX_DELAY) ? NEVER : gNow + ticks * PS_PER_TICK;
+    while (sem->count == 0) {
+        if (gIsrDepth > 0 || ! step(deadline)) {
+            if (ticks == portMAX_DELAY) {
+                fprintf(stderr, "sim: waiting forever for a semaphore nothing will give\n");
+                abort();
+            }
+            if (deadline > gNow) gNow = deadline;
+            return pdFALSE;
+        }
+    }
+    sem->count--;
+    return pdTRUE;
+}
+
+// -- Memory
+extern "C" void * heap_caps_malloc(size_t size, uint32_t caps)
+{
+    if (caps & MALLOC_CAP_DMA) {
+        if (gFailDmaAlloc > 0) {
+            gFailDmaAlloc--;
+            return NULL;
+        }
+        if (gDmaBase == 0) gDmaBase = (uint8_t *) aligned_alloc(DMA_REGION, DMA_REGION);
+        size = (size + 3) & ~3;
+        if (gDmaUsed + size > DMA_REGION) return NULL;
+        void * p = gDmaBase + gDmaUsed;
+        gDmaUsed += size;
+        return p;
+    }
+    return malloc(size);
+}
+
+extern "C" void * heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    void * p = heap_caps_malloc(n * size, caps);
+    if (p) memset(p, 0, n * size);
+    return p;
+}
+
+extern "C" void heap_caps_free(void * ptr)
+{
+    uint8_t * p = (uint8_t *) ptr;
+    if (gDmaBase && p >= gDmaBase && p < gDmaBase + DMA_REGION) return;
+    free(ptr);
+}
+
+// -- Interrupts
+extern "C" esp_err_t esp_intr_alloc(int source, int flags, intr_handler_t handler, void * arg, intr_handle_t * ret_handle)
+{
+    intr_handle_data_t * h = new intr_handle_data_t();
+    h->source = source;
+    h->handler = handler;
+    h->arg = arg;
+    h->enabled = true;
+    gHandlers.push_back(h);
+    if (ret_handle) *ret_handle = h;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t esp_intr_enable(intr_handle_t handle) { handle->enabled = true; return ESP_OK; }
+extern "C" esp_err_t esp_intr_disable(intr_handle_t handle) { handle->enabled = false; return ESP_OK; }
+
+extern "C" esp_err_t esp_intr_free(intr_handle_t handle)
+{
+    for (size_t i = 0; i < gHandlers.size(); i++) {
+        if (gHandlers[i] == handle) gHandlers.erase(gHandlers.begin() + i);
+    }
+    delete handle;
+    return ESP_OK;
+}
+
+// -- GPIO
+extern "C" esp_err_t gpio_set_direction(gpio_num_t gpio, gpio_mode_t mode) { return ESP_OK; }
+
+extern "C" void gpio_matrix_out(uint32_t gpio, uint32_t signal_idx, bool out_inv, bool oen_inv)
+{
+    gPinSignal.erase(gpio);
+    if (signal_idx >= I2S0O_DATA_OUT0_IDX && signal_idx < I2S0O_DATA_OUT0_IDX + 24) {
+        gPinSignal[gpio] = I2S_SIGNAL + (signal_idx - I2S0O_DATA_OUT0_IDX);
+    } else if (signal_idx >= I2S1O_DATA_OUT0_IDX && signal_idx < I2S1O_DATA_OUT0_IDX + 24) {
+        gPinSignal[gpio] = I2S_SIGNAL + 100 + (signal_idx - I2S1O_DATA_OUT0_IDX);
+    }
+}
+
+extern "C" void periph_module_enable(periph_module_t periph) { }
+
+extern "C" void pinMode(uint8_t pin, uint8_t mode) { }
+extern "C" void digitalWrite(uint8_t pin, uint8_t val) { }
+extern "C" void spi_flash_op_lock(void) { }
+extern "C" void spi_flash_op_unlock(void) { }
+
+// -- RMT
+extern "C" esp_err_t rmt_config(const rmt_config_t * config)
+{
+    gRmt[config->channel].blocks = config->mem_block_num;
+    return ESP_OK;
+}
+
+// -- The built-in RMT driver is not simulated
+extern "C" esp_err_t rmt_driver_install(rmt_channel_t channel, size_t rx_buf_size, int intr_alloc_flags)
+{
+    fprintf(stderr, "sim: FASTLED_RMT_BUILTIN_DRIVER is not supported\n");
+    abort();
+}
+
+extern "C" esp_err_t rmt_set_tx_thr_intr_en(rmt_channel_t channel, bool en, uint16_t evt_thresh)
+{
+    gRmt[channel].thrEn = en;
+    gRmt[channel].thr = evt_thresh;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rmt_set_tx_intr_en(rmt_channel_t channel, bool en)
+{
+    gRmt[channel].endEn = en;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rmt_tx_start(rmt_channel_t channel, bool tx_idx_rst)
+{
+    RmtChannel & c = gRmt[channel];
+    if (tx_idx_rst) c.idx = 0;
+    c.sent = 0;
+    c.pendingThr = false;
+    c.endNext = false;
+    c.running = true;
+    c.next = gNow;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rmt_tx_stop(rmt_channel_t channel)
+{
+    gRmt[channel].running = false;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rmt_set_pin(rmt_channel_t channel, rmt_mode_t mode, gpio_num_t gpio_num)
+{
+    gPinSignal[gpio_num] = RMT_SIGNAL + channel;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rmt_set_mem_block_num(rmt_channel_t channel, uint8_t rmt_mem_num)
+{
+    gRmt[channel].blocks = rmt_mem_num;
+    return ESP_OK;
+}
+
+extern "C" void * rmt_register_tx_end_callback(rmt_tx_end_fn_t function, void * arg) { return 0; }
+
+extern "C" esp_err_t rmt_write_items(rmt_channel_t channel, const rmt_item32_t * rmt_item, int item_num, bool wait_tx_done)
+{
+    return ESP_FAIL;
+}
+
+// -- Provided by the sketch, for blur2d()
+uint16_t XY(uint8_t x, uint8_t y)
+{
+    return y * 16 + x;
+}
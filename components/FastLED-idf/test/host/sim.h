@@ -0,0 +1,57 @@
+#pragma once
+
+// -- Host simulation of the ESP32 peripherals used by the LED drivers
+//    Time only moves when the code under test waits for something:
+//    micros(), delay(), vTaskDelay(), or taking a semaphore that is not
+//    available. While it moves, the simulated RMT channels and I2S DMA
+//    play out what the drivers wrote into RMTMEM and the lldesc_t
+//    chains, raise their interrupts, and record the level of every
+//    GPIO pin they drive.
+
+#include <stdint.h>
+#include <vector>
+
+namespace sim {
+
+// -- One stretch of constant level on a pin
+struct Segment {
+    uint8_t  level;
+    uint64_t ps;
+};
+
+typedef std::vector<Segment> Waveform;
+
+// -- Simulated time, in picoseconds
+uint64_t now();
+
+// -- Run the hardware for ns (or until nothing is running)
+void run(uint64_t ns);
+void runUntilIdle();
+bool idle();
+
+// -- Levels driven on a pin since clearWaveforms(), starting at the
+//    time of the first edge; gaps are low
+const Waveform & waveform(int pin);
+void clearWaveforms();
+
+// -- Number of ESP_LOGE messages since the last call
+int takeErrors();
+
+// -- Take the next RMT interrupt ns late, to make a refill late
+void delayNextRmtIsr(uint32_t ns);
+
+// -- Depth of the I2S output FIFO, in 32-bit words (64 by default)
+//    The out_eof interrupt fires when the DMA has read a buffer, which
+//    is up to this many words before it has been sent.
+void setI2sFifoWords(int words);
+
+// -- Make the next n esp_timer_create() calls fail
+void failTimerCreate(int n);
+
+// -- Number of esp_timer_create() calls so far
+int timersCreated();
+
+// -- Make the next n heap_caps_malloc(MALLOC_CAP_DMA) calls fail
+void failDmaAlloc(int n);
+
+} // namespace sim
@@ -0,0 +1,82 @@
+// -- The word at a time nscale8() and nblend() for CRGB arrays against
+//    scale8() and blend8() one pixel at a time: every scale and amount,
+//    every alignment of the arrays, every length up to a few words, and
+//    overlapping arrays. Built once per setting of FASTLED_SCALE8_FIXED
+//    and FASTLED_BLEND_FIXED (see CMakeLists.txt).
+
+#include "harness.h"
+
+#define MAX_LEDS 9
+
+// -- Room for two arrays of MAX_LEDS pixels, each at any offset from a
+//    word boundary
+#define MAX_BYTES (2 * (3 * MAX_LEDS + 4))
+
+static uint8_t gNew[MAX_BYTES] __attribute__ ((aligned (4)));
+static uint8_t gRef[MAX_BYTES];
+static int gMismatches = 0;
+
+static void fillBytes()
+{
+    for (int i = 0; i < MAX_BYTES; i++) gNew[i] = random8();
+    memcpy(gRef, gNew, MAX_BYTES);
+}
+
+static void checkScale(int offset, int n, uint8_t scale)
+{
+    fillBytes();
+    nscale8((CRGB *) (gNew + offset), n, scale);
+    for (int i = 0; i < 3 * n; i++) {
+        gRef[offset + i] = scale8(gRef[offset + i], scale);
+    }
+    if (memcmp(gNew, gRef, MAX_BYTES) != 0 && gMismatches++ < 10) {
+        fprintf(stderr, "nscale8: scale %d, offset %d, %d leds\n", scale, offset, n);
+    }
+}
+
+// -- Blend n pixels at byte e with the ones at byte o, and compare with
+//    the single pixel nblend() going front to back
+static void checkBlend(int e, int o, int n, uint8_t amount)
+{
+    fillBytes();
+    nblend((CRGB *) (gNew + e), (CRGB *) (gNew + o), n, amount);
+    for (int i = 0; i < n; i++) {
+        uint8_t * a = gRef + e + 3 * i;
+        const uint8_t * b = gRef + o + 3 * i;
+        for (int c = 0; c < 3 && amount; c++) {
+            a[c] = (amount == 255) ? b[c] : blend8(a[c], b[c], amount);
+        }
+    }
+    if (memcmp(gNew, gRef, MAX_BYTES) != 0 && gMismatches++ < 10) {
+        fprintf(stderr, "nblend: amount %d, existing at %d, overlay at %d, %d leds\n", amount, e, o, n);
+    }
+}
+
+int main()
+{
+    for (int scale = 0; scale < 256; scale++) {
+        for (int offset = 0; offset < 4; offset++) {
+            for (int n = 0; n <= MAX_LEDS; n++) {
+                checkScale(offset, n, scale);
+            }
+        }
+    }
+
+    // -- Separate arrays at any pair of offsets, then an overlay up to
+    //    two pixels behind or ahead of the existing pixels
+    for (int amount = 0; amount < 256; amount++) {
+        for (int e = 0; e < 4; e++) {
+            for (int n = 0; n <= MAX_LEDS; n++) {
+                for (int o = 0; o < 4; o++) {
+                    checkBlend(e, 3 * MAX_LEDS + 4 + o, n, amount);
+                }
+                for (int shift = -2; shift <= 2 && n <= MAX_LEDS - 2; shift++) {
+                    checkBlend(e + 6, e + 6 + 3 * shift, n, amount);
+                }
+            }
+        }
+    }
+
+    CHECK(gMismatches == 0);
+    return finish("test_colorutils");
+}
@@ -0,0 +1,104 @@
+// -- Round trip through the I2S driver
+//    Three strips of different lengths, sent in parallel. Built once
+//    per group of driver options (see CMakeLists.txt).
+
+#include "harness.h"
+
+#define NUM_STRIPS 3
+
+static CRGB leds0[30];
+static CRGB leds1[75];
+static CRGB leds2[8];
+
+static Strip strips[NUM_STRIPS];
+
+template <typename T>
+static Strip addStrip(T * controller, int pin, CRGB * leds, int n)
+{
+    FastLED.addLeds(controller, leds, n);
+    Strip strip = { controller, controller, pin, &WS2812_TIMING, leds, n };
+    return strip;
+}
+
+// -- Wait for the frame in flight, however the driver sends it
+static void waitSent()
+{
+#if FASTLED_I2S_FULL_FRAME
+    i2sWaitForShowDone();
+#endif
+    sim::runUntilIdle();
+}
+
+int main()
+{
+    // -- Out of DMA memory: nothing is sent, and the next show() tries
+    //    again. The ring buffers are first allocated in init().
+#if FASTLED_I2S_FULL_FRAME
+    const int dmaFailures = 1;
+#else
+    const int dmaFailures = 2;
+#endif
+    sim::failDmaAlloc(dmaFailures);
+
+    strips[0] = addStrip(new Tap<WS2812<12, GRB>, GRB>(), 12, leds0, 30);
+    strips[1] = addStrip(new Tap<WS2812<13, GRB>, GRB>(), 13, leds1, 75);
+    strips[2] = addStrip(new Tap<WS2812<14, GRB>, GRB>(), 14, leds2, 8);
+
+    FastLED.setDither(DISABLE_DITHER);
+    FastLED.setBrightness(255);
+    sim::clearWaveforms();
+    FastLED.show();
+    waitSent();
+    CHECK(sim::takeErrors() == dmaFailures);
+    for (int i = 0; i < NUM_STRIPS; i++) {
+        CHECK(sim::waveform(strips[i].pin).empty());
+        strips[i].log->sent.clear();
+    }
+
+    // -- Unscaled and undithered, the pixels go out as they are
+    for (int i = 0; i < NUM_STRIPS; i++) fillRandom(strips[i].leds, strips[i].numLeds);
+    std::vector<uint8_t> raw[NUM_STRIPS];
+    for (int i = 0; i < NUM_STRIPS; i++) raw[i] = rawBytes(strips[i].leds, strips[i].numLeds, GRB);
+    sim::clearWaveforms();
+    FastLED.show();
+    waitSent();
+    for (int i = 0; i < NUM_STRIPS; i++) {
+        std::vector<DecodedFrame> frames = decodeFrames(sim::waveform(strips[i].pin), WS2812_TIMING);
+        CHECK(frames.size() == 1);
+        if (frames.size() == 1) CHECK(frames[0].bytes == raw[i]);
+        strips[i].log->sent.clear();
+    }
+
+    // -- Scaled and dithered. Every frame must get out whole, up to the
+    //    last bit of the longest strip, which is still in the I2S FIFO
+    //    when the DMA is done with its buffer.
+#if FASTLED_TEMPORAL_DITHER
+    FastLED.setDither(TEMPORAL_DITHER);
+#else
+    FastLED.setDither(BINARY_DITHER);
+#endif
+    for (int frame = 0; frame < 40; frame++) {
+        FastLED.setBrightness((frame % 3 == 0) ? 255 : (frame % 3 == 1) ? 128 : 37);
+        for (int i = 0; i < NUM_STRIPS; i++) fillRandom(strips[i].leds, strips[i].numLeds);
+        sim::clearWaveforms();
+        FastLED.show();
+        waitSent();
+        for (int i = 0; i < NUM_STRIPS; i++) {
+            checkStrip(strips[i], 1);
+        }
+    }
+
+#if ! FASTLED_I2S_FULL_FRAME
+    // -- A subset: the other strips stay silent
+    CLEDController * subset[] = { strips[2].controller, strips[0].controller };
+    sim::clearWaveforms();
+    FastLED.flushLeds(subset, 2);
+    waitSent();
+    for (int i = 0; i < NUM_STRIPS; i++) {
+        checkStrip(strips[i], 1);
+    }
+#endif
+
+    CHECK(sim::takeErrors() == 0);
+    return finish("test_i2s");
+}
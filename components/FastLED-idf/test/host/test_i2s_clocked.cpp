@@ -0,0 +1,126 @@
+// -- Round trip through the I2S driver for clocked chipsets
+//    Two APA102 strips of different lengths on a shared clock. The data
+//    pins are read on the rising edges of the clock pin.
+
+#include "harness.h"
+
+#define NUM_STRIPS 2
+#define CLOCK_PIN 14
+
+static CRGB leds0[20];
+static CRGB leds1[50];
+
+static Strip strips[NUM_STRIPS];
+
+template <typename T>
+static Strip addStrip(T * controller, int pin, CRGB * leds, int n)
+{
+    FastLED.addLeds(controller, leds, n);
+    Strip strip = { controller, controller, pin, NULL, leds, n };
+    return strip;
+}
+
+// -- The data pin's level at each rising edge of the clock, MSB first
+//    Both waveforms start with the first word of the frame.
+static std::vector<uint8_t> decodeClocked(const sim::Waveform & data, const sim::Waveform & clock)
+{
+    std::vector<uint8_t> bytes;
+    size_t d = 0;
+    uint64_t dataEnd = data.empty() ? 0 : data[0].ps;
+    uint64_t t = 0;
+    uint8_t level = 0;
+    uint8_t byte = 0;
+    int bits = 0;
+    for (size_t c = 0; c < clock.size(); t += clock[c].ps, level = clock[c].level, c++) {
+        if (level || ! clock[c].level) continue;
+        while (d < data.size() && dataEnd <= t) {
+            d++;
+            if (d < data.size()) dataEnd += data[d].ps;
+        }
+        byte = (byte << 1) | (d < data.size() ? data[d].level : 0);
+        if (++bits == 8) {
+            bytes.push_back(byte);
+            byte = 0;
+            bits = 0;
+        }
+    }
+    return bytes;
+}
+
+// -- Check what went out on the strip's data pin: the start frame,
+//    the Tap's pixels at full brightness, and the end frame, then zeros
+//    up to the end of the last buffer. A strip that was not shown only
+//    gets zeros.
+static void checkClocked(Strip & strip, int frameBytes)
+{
+    std::vector<uint8_t> got = decodeClocked(sim::waveform(strip.pin), sim::waveform(CLOCK_PIN));
+    CHECK((int) got.size() == frameBytes);
+
+    std::vector<uint8_t> expected(4, 0);
+    if ( ! strip.log->sent.empty()) {
+        CHECK(strip.log->sent.size() == 1);
+        const std::vector<uint8_t> & px = strip.log->sent.back();
+        for (size_t i = 0; i < px.size(); i += 3) {
+            expected.push_back(0xFF);
+            expected.insert(expected.end(), px.begin() + i, px.begin() + i + 3);
+        }
+        for (int i = 0; i < strip.numLeds / 32 + 1; i++) {
+            expected.push_back(0xFF);
+            expected.insert(expected.end(), 3, 0);
+        }
+    }
+    expected.resize(frameBytes, 0);
+    CHECK(got == expected);
+
+    strip.log->sent.clear();
+}
+
+// -- Bytes sent per strip: the longest strip, in whole buffers
+static int frameBytes(int numLeds)
+{
+    int bytes = 4 + 4 * numLeds + 4 * (numLeds / 32 + 1);
+    int buffer = FASTLED_I2S_CLOCKED_BYTES_PER_BUFFER;
+    return (bytes + buffer - 1) / buffer * buffer;
+}
+
+int main()
+{
+    // -- Out of DMA memory: the buffers are first allocated in init(),
+    //    then again by show(), which drops the frame
+    sim::failDmaAlloc(3);
+
+    strips[0] = addStrip(new Tap<I2SClockedController<12, CLOCK_PIN, BGR>, BGR>(), 12, leds0, 20);
+    strips[1] = addStrip(new Tap<I2SClockedController<13, CLOCK_PIN, BGR>, BGR>(), 13, leds1, 50);
+
+    FastLED.setDither(DISABLE_DITHER);
+    FastLED.setBrightness(255);
+    sim::clearWaveforms();
+    FastLED.show();
+    sim::runUntilIdle();
+    CHECK(sim::takeErrors() == 2);
+    CHECK(sim::waveform(CLOCK_PIN).empty());
+    for (int i = 0; i < NUM_STRIPS; i++) strips[i].log->sent.clear();
+
+    // -- Scaled and dithered, several buffers long. show() returns
+    //    once the frame is out.
+    FastLED.setDither(BINARY_DITHER);
+    for (int frame = 0; frame < 10; frame++) {
+        FastLED.setBrightness((frame % 3 == 0) ? 255 : (frame % 3 == 1) ? 128 : 37);
+        for (int i = 0; i < NUM_STRIPS; i++) fillRandom(strips[i].leds, strips[i].numLeds);
+        sim::clearWaveforms();
+        FastLED.show();
+        for (int i = 0; i < NUM_STRIPS; i++) {
+            checkClocked(strips[i], frameBytes(50));
+        }
+    }
+
+    // -- A subset: the other strip is clocked zeros, which it ignores
+    CLEDController * subset[] = { strips[0].controller };
+    sim::clearWaveforms();
+    FastLED.flushLeds(subset, 1);
+    checkClocked(strips[0], frameBytes(20));
+    checkClocked(strips[1], frameBytes(20));
+
+    CHECK(sim::takeErrors() == 0);
+    return finish("test_i2s_clocked");
+}
@@ -0,0 +1,24 @@
+// -- Frame pacing when the one-shot timer cannot be created
+//    show() must still keep to the target rate, by spinning, and must
+//    not try to create the timer again every frame.
+
+#include "harness.h"
+
+int main()
+{
+    FastLED.setTargetFPS(100);
+    sim::failTimerCreate(1);
+
+    FastLED.show();
+    uint64_t last = sim::now();
+    for (int frame = 0; frame < 10; frame++) {
+        FastLED.show();
+        uint64_t periodUs = (sim::now() - last) / 1000000;
+        last = sim::now();
+        CHECK(periodUs >= 10000 && periodUs < 10100);
+    }
+
+    CHECK(sim::timersCreated() == 1);
+    CHECK(sim::takeErrors() == 0);
+    return finish("test_pacing");
+}
@@ -0,0 +1,110 @@
+// -- Round trip through the RMT driver
+//    Six strips on four channels (MEM_BLOCK_NUM 2), so some of them
+//    wait for a channel; mixed color orders and lengths, and one RGBW
+//    strip. Built once per group of driver options (see CMakeLists.txt).
+
+#include "harness.h"
+
+#define NUM_STRIPS 6
+
+static CRGB leds0[37];
+static CRGB leds1[100];
+static CRGB leds2[1];
+static CRGB leds3[64];
+static CRGB leds4[250];
+static CRGB leds5[45];
+
+static Strip strips[NUM_STRIPS];
+
+template <typename T>
+static Strip addStrip(T * controller, int pin, const BitTiming & timing, CRGB * leds, int n)
+{
+    FastLED.addLeds(controller, leds, n);
+    Strip strip = { controller, controller, pin, &timing, leds, n };
+    return strip;
+}
+
+// -- Show a frame and check every strip
+static void showAndCheck(bool allowRetries = false)
+{
+    sim::clearWaveforms();
+    FastLED.show();
+    sim::runUntilIdle();
+    for (int i = 0; i < NUM_STRIPS; i++) {
+        checkStrip(strips[i], 4, allowRetries);
+    }
+}
+
+int main()
+{
+    strips[0] = addStrip(new Tap<WS2812<12, GRB>, GRB>(), 12, WS2812_TIMING, leds0, 37);
+    strips[1] = addStrip(new Tap<WS2812<13, RGB>, RGB>(), 13, WS2812_TIMING, leds1, 100);
+    strips[2] = addStrip(new Tap<WS2812<14, BRG>, BRG>(), 14, WS2812_TIMING, leds2, 1);
+    strips[3] = addStrip(new Tap<WS2812<15, GRB>, GRB>(), 15, WS2812_TIMING, leds3, 64);
+    strips[4] = addStrip(new Tap<WS2812<16, GRB>, GRB>(), 16, WS2812_TIMING, leds4, 250);
+    strips[5] = addStrip(new Tap<SK6812RGBW<17, GRB>, GRB, FASTLED_RGBW_WHITE_MODE>(), 17, SK6812_TIMING, leds5, 45);
+
+    // -- Unscaled and undithered, the pixels go out as they are
+    FastLED.setDither(DISABLE_DITHER);
+    FastLED.setBrightness(255);
+    for (int i = 0; i < NUM_STRIPS; i++) fillRandom(strips[i].leds, strips[i].numLeds);
+    const EOrder orders[] = { GRB, RGB, BRG, GRB, GRB };
+    std::vector<uint8_t> raw[5];
+    for (int i = 0; i < 5; i++) raw[i] = rawBytes(strips[i].leds, strips[i].numLeds, orders[i]);
+    sim::clearWaveforms();
+    FastLED.show();
+    sim::runUntilIdle();
+    for (int i = 0; i < 5; i++) {
+        std::vector<DecodedFrame> frames = decodeFrames(sim::waveform(strips[i].pin), WS2812_TIMING);
+        CHECK(frames.size() == 1);
+        if (frames.size() == 1) {
+            std::vector<uint8_t> sent(frames[0].bytes.begin(), frames[0].bytes.begin() + raw[i].size());
+            CHECK(sent == raw[i]);
+        }
+    }
+    for (int i = 0; i < NUM_STRIPS; i++) strips[i].log->sent.clear();
+
+    // -- Scaled and dithered; binary dithering starts once the frame
+    //    rate is known to be high enough
+#if FASTLED_TEMPORAL_DITHER
+    FastLED.setDither(TEMPORAL_DITHER);
+#else
+    FastLED.setDither(BINARY_DITHER);
+#endif
+    for (int frame = 0; frame < 40; frame++) {
+        FastLED.setBrightness((frame % 3 == 0) ? 255 : (frame % 3 == 1) ? 128 : 37);
+        for (int i = 0; i < NUM_STRIPS; i++) fillRandom(strips[i].leds, strips[i].numLeds);
+        showAndCheck();
+    }
+
+    // -- A subset, with one controller listed twice: it is sent once
+    CLEDController * subset[] = { strips[1].controller, strips[4].controller, strips[1].controller };
+    sim::clearWaveforms();
+    FastLED.flushLeds(subset, 3);
+    sim::runUntilIdle();
+    CHECK(strips[1].log->sent.size() == 2);
+    strips[1].log->sent.erase(strips[1].log->sent.begin());
+    for (int i = 0; i < NUM_STRIPS; i++) {
+        checkStrip(strips[i], 4);
+    }
+
+#if FASTLED_RMT_MAX_RETRIES > 0
+    // -- A late refill cuts a strip short; it is resent in full
+    ESP32RMTStats before;
+    ESP32RMTController::getStats(&before);
+    sim::delayNextRmtIsr(150000);
+    fillRandom(leds4, 250);
+    showAndCheck(true);
+    ESP32RMTStats after;
+    ESP32RMTController::getStats(&after);
+    CHECK(after.lostFrames == before.lostFrames);
+    int retries = 0;
+    for (int ch = 0; ch < FASTLED_RMT_MAX_CHANNELS; ch++) {
+        retries += after.channel[ch].retries - before.channel[ch].retries;
+    }
+    CHECK(retries >= 1);
+#endif
+
+    CHECK(sim::takeErrors() == 0);
+    return finish("test_rmt");
+}